@@ -13,7 +13,7 @@ void StaticDataModel::computeCumulativeFreqs(const std::vector<unsigned>& freqs)
 	for (size_t i = 0; i < cumulativeFreqs.size(); ++i) {
 		cumulativeFreqs[i] = i > 0 ? (cumulativeFreqs[i - 1] + freqs[i]) : freqs[i];
 		// handle overflow
-		if (cumulativeFreqs[i] > MAX_FREQ) {
+		if (cumulativeFreqs[i] > maxFreq) {
 			// divide all frequencies bigger than 1 by two and compute new cumulative frequencies
 			auto newFreqs = freqs;
 			for (auto& f : newFreqs) {
@@ -25,3 +25,40 @@ void StaticDataModel::computeCumulativeFreqs(const std::vector<unsigned>& freqs)
 		}
 	}
 }
+
+FenwickDataModel::FenwickDataModel(std::size_t numSymbols, unsigned maxFreq) : freqs(numSymbols), tree(numSymbols),
+	total(0), maxFreq(maxFreq), topBit(1) {
+
+	assert(numSymbols > 0 && maxFreq <= DataModel::MAX_FREQ && maxFreq >= 2 * numSymbols);
+	while (topBit * 2 <= numSymbols)
+		topBit *= 2;
+	reset();
+}
+
+void FenwickDataModel::reset() {
+	std::fill(freqs.begin(), freqs.end(), 1U);
+	build();
+}
+
+void FenwickDataModel::rescale() {
+	for (auto& f : freqs) {
+		if (f > 1)
+			f /= 2;
+	}
+	build();
+}
+
+void FenwickDataModel::build() {
+	total = 0;
+	for (size_t i = 0; i < freqs.size(); ++i) {
+		tree[i] = freqs[i];
+		total += freqs[i];
+	}
+
+	// add every node to its parent, parents follow children
+	for (size_t i = 1; i <= tree.size(); ++i) {
+		size_t parent = i + (i & (0 - i));
+		if (parent <= tree.size())
+			tree[parent - 1] += tree[i - 1];
+	}
+}
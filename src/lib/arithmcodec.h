@@ -33,8 +33,8 @@ public:
 class StaticDataModel : public DataModel
 {
 public:
-	StaticDataModel() {}
-	explicit StaticDataModel(const std::vector<unsigned>& freqs) {
+	StaticDataModel() : maxFreq(MAX_FREQ) {}
+	explicit StaticDataModel(const std::vector<unsigned>& freqs) : maxFreq(MAX_FREQ) {
 		computeCumulativeFreqs(freqs);
 	}
 
@@ -64,10 +64,41 @@ public:
 	virtual std::size_t size() const {
 		return cumulativeFreqs.size();
 	}
+
+	// following methods are used by templated coders, they aren't virtual,
+	// so coder that knows concrete model type gets them inlined
+
+	/// Get sum of all symbol frequencies.
+	unsigned totalFreq() const {
+		return cumulativeFreqs.back();
+	}
+
+	/// Get lower bound of symbol interval, that's cumulative frequency of previous symbol.
+	unsigned lowFreq(unsigned symbol) const {
+		return symbol != 0 ? cumulativeFreqs[symbol - 1] : 0U;
+	}
+
+	/// Get upper bound of symbol interval, that's cumulative frequency of symbol.
+	unsigned highFreq(unsigned symbol) const {
+		return cumulativeFreqs[symbol];
+	}
+
+	/// Finds symbol whose interval contains freq, 0 when there's no such symbol.
+	unsigned findSymbol(unsigned freq) const {
+		for (size_t i = 0; i < cumulativeFreqs.size(); ++i) {
+			if (lowFreq(i) <= freq && freq < cumulativeFreqs[i])
+				return i;
+		}
+		return 0;
+	}
+
+	/// Static model doesn't change its frequencies.
+	void update(unsigned) { }
 protected:
 	void computeCumulativeFreqs(const std::vector<unsigned>& freqs);
 
 	std::vector<unsigned> cumulativeFreqs;
+	unsigned maxFreq;		/// frequencies are halved when their sum exceeds this
 };
 
 /**
@@ -81,8 +112,12 @@ public:
 	 * Creates new data model
 	 * Sets all symbol frequencies to 1.
 	 * @param numSymbols number of symbols in frequency table, created by this call
+	 * @param maxFreq maximal sum of frequencies, coders with less precision
+	 *     need lower limit, it must not be greater than MAX_FREQ
 	 */
-	explicit AdaptiveDataModel(std::size_t numSymbols) {
+	explicit AdaptiveDataModel(std::size_t numSymbols, unsigned maxFreq = MAX_FREQ) {
+		assert(maxFreq <= MAX_FREQ && maxFreq >= 2 * numSymbols);
+		this->maxFreq = maxFreq;
 		cumulativeFreqs.resize(numSymbols);
 		reset();
 	}
@@ -108,7 +143,7 @@ public:
 		for (auto i = symbol; i < cumulativeFreqs.size(); ++i) {
 			cumulativeFreqs[i] += freq;
 			// on overflow set overflow flag
-			if (cumulativeFreqs[i] > MAX_FREQ)
+			if (cumulativeFreqs[i] > maxFreq)
 				overflow = true;
 		}
 
@@ -124,6 +159,131 @@ public:
 			computeCumulativeFreqs(freqs);
 		}
 	}
+
+	/// Called by templated coders after symbol is coded.
+	void update(unsigned symbol) {
+		incSymbolFreq(symbol);
+	}
+};
+
+/**
+ * Adaptive data model for big alphabets.
+ * Frequencies are kept in Fenwick (binary indexed) tree, so update of
+ * symbol frequency, cumulative frequency lookup and search of symbol by
+ * cumulative frequency take O(log n) instead of O(n) of AdaptiveDataModel.
+ * Frequencies evolve same way as in AdaptiveDataModel, so both models give
+ * same code. It's usable only by templated coders.
+ */
+class FenwickDataModel
+{
+public:
+	/**
+	 * Creates new data model with all frequencies set to 1.
+	 * @param numSymbols number of symbols
+	 * @param maxFreq maximal sum of frequencies, see AdaptiveDataModel
+	 */
+	explicit FenwickDataModel(std::size_t numSymbols, unsigned maxFreq = DataModel::MAX_FREQ);
+
+	/// Resets data model to initial state, which is all frequencies to 1.
+	void reset();
+
+	std::size_t size() const {
+		return freqs.size();
+	}
+
+	unsigned totalFreq() const {
+		return total;
+	}
+
+	unsigned lowFreq(unsigned symbol) const {
+		return prefixSum(symbol);
+	}
+
+	unsigned highFreq(unsigned symbol) const {
+		return prefixSum(symbol) + freqs[symbol];
+	}
+
+	/// Finds symbol whose interval contains freq, last symbol when freq is out of range.
+	unsigned findSymbol(unsigned freq) const {
+		// descend tree from highest power of two, pos ends as number of
+		// symbols whose cumulative frequency is not greater than freq
+		size_t pos = 0;
+		for (size_t step = topBit; step != 0; step >>= 1) {
+			if (pos + step <= tree.size() && tree[pos + step - 1] <= freq) {
+				pos += step;
+				freq -= tree[pos - 1];
+			}
+		}
+		return static_cast<unsigned>(std::min(pos, freqs.size() - 1));
+	}
+
+	/// Increments symbol frequency, frequencies are halved when their sum exceeds limit.
+	void update(unsigned symbol) {
+		freqs[symbol]++;
+		total++;
+		if (total > maxFreq) {
+			rescale();
+			return;
+		}
+
+		for (size_t i = symbol + 1; i <= tree.size(); i += i & (0 - i))
+			tree[i - 1]++;
+	}
+private:
+	/// Get sum of frequencies of symbols lower than symbol.
+	unsigned prefixSum(unsigned symbol) const {
+		unsigned sum = 0;
+		for (size_t i = symbol; i != 0; i -= i & (0 - i))
+			sum += tree[i - 1];
+		return sum;
+	}
+
+	/// Halves frequencies bigger than 1 and rebuilds tree.
+	void rescale();
+
+	/// Builds tree from frequencies in O(n).
+	void build();
+
+	std::vector<unsigned> freqs;	/// frequency of every symbol
+	std::vector<unsigned> tree;		/// node i - 1 holds sum of freqs (i - (i & -i), i]
+	unsigned total;
+	unsigned maxFreq;
+	size_t topBit;					/// highest power of two not greater than number of symbols
+};
+
+/**
+ * Adapts any DataModel to interface of templated coders.
+ * Frequencies are read through virtual calls and model is never updated,
+ * it's used by polymorphic coder entry points for non adaptive models.
+ */
+class DataModelRef
+{
+public:
+	explicit DataModelRef(const DataModel& model) : model(model) { }
+
+	unsigned totalFreq() const {
+		return model.getCumulativeFreq(model.size() - 1);
+	}
+
+	unsigned lowFreq(unsigned symbol) const {
+		return symbol != 0 ? model.getCumulativeFreq(symbol - 1) : 0U;
+	}
+
+	unsigned highFreq(unsigned symbol) const {
+		return model.getCumulativeFreq(symbol);
+	}
+
+	unsigned findSymbol(unsigned freq) const {
+		for (size_t i = 0; i < model.size(); ++i) {
+			if (lowFreq(i) <= freq && freq < highFreq(i))
+				return i;
+		}
+		return 0;
+	}
+
+	void update(unsigned) { }
+private:
+	const DataModel& model;
 };
 
 template <size_t N>
@@ -151,6 +311,19 @@ inline bool getBit(unsigned value, size_t n) {
 	return !!(value & (1U << n));
 }
 
+/**
+ * Constants of byte oriented range coder.
+ * Range is kept between BOTTOM and 2^32 by shifting out whole bytes,
+ * so sum of model frequencies mustn't exceed MAX_TOTAL.
+ */
+struct RangeCoderTraits
+{
+	/// Range is renormalized when it drops below this value
+	static const uint32_t BOTTOM = 1U << 24;
+	/// Maximal sum of frequencies, range / total is then at least 2^8
+	static const uint32_t MAX_TOTAL = 1U << 16;
+};
+
 /**
  * Traits for interval used in arithmetic coding
  * @param N precision in bytes we want for our interval
@@ -16,10 +16,51 @@
 class ArithmeticDecoder
 {
 public:
-	explicit ArithmeticDecoder(std::shared_ptr<BitStreamReader>& bsr);
+	/**
+	 * Constructs new decoder and reads start of code.
+	 * Encoder doesn't write trailing zeros of code, so reader is switched
+	 * to return zeros past end of data.
+	 * @param bsr reader of code
+	 */
+	explicit ArithmeticDecoder(const std::shared_ptr<BitStreamReader>& bsr);
 
 	void reset();
 
+	/**
+	 * Decodes symbol with data model.
+	 * Model type is known at compile time, see ArithmeticEncoder::encode.
+	 * @param model data model with frequencies, it's updated after symbol is decoded
+	 * @return decoded symbol
+	 */
+	template <class Model>
+	unsigned decode(Model& model) {
+		uint64_t range = intervalHigh - intervalLow + 1;
+		auto scale = model.totalFreq();
+		auto cumulativeFreq = ((value - intervalLow + 1) * scale - 1) / range;
+
+		// find i where cumuliveFreqs[i-1] <= cumulativeFreq < cumulativeFreqs[i]
+		unsigned symbol = model.findSymbol(static_cast<unsigned>(cumulativeFreq));
+
+		// compute new interval bounds
+
+		// interval upper bound is
+		intervalHigh = intervalLow + (range * model.highFreq(symbol)) / scale - 1;
+
+		// interval lower bound is computed as low + (r * cumFreq(i-1)) / s and cumFreq(-1) == 0 so
+		// if symbol == 0 then interval lower bound is not modified 
+		if (symbol != 0)
+			intervalLow += (range * model.lowFreq(symbol)) / scale;
+
+		renormalize();
+		model.update(symbol);
+
+		return symbol;
+	}
+
+	/**
+	 * Decodes symbol with data model of unknown type.
+	 * Only adaptive data models are updated.
+	 */
 	unsigned decode(DataModel* dataModel);
 
 	std::shared_ptr<BitStreamReader> reader() {
@@ -28,7 +69,36 @@ public:
 private:
 	typedef IntervalTraits<sizeof(uint32_t)> IntervalTraitsType;
 
-	void readBit();
+	void readBit() {
+		value = (value << 1) | (bitStreamReader->readBit() ? 1U : 0U);
+	}
+
+	/// Enlarges interval after symbol was decoded and gets bits from data.
+	void renormalize() {
+		// loop ends when interval is large enough
+		for (;;) {
+			// interval is in lower half of possible range
+			if (intervalHigh < IntervalTraitsType::HALF) {
+				;	// do nothing
+			// interval is in upper half of possible range
+			} else if (intervalLow >= IntervalTraitsType::HALF) {
+				intervalLow -= IntervalTraitsType::HALF;
+				intervalHigh -= IntervalTraitsType::HALF;
+				value -= IntervalTraitsType::HALF;
+			// interval is in middle of possible range
+			} else if (intervalLow >= IntervalTraitsType::QUARTER && intervalHigh <= IntervalTraitsType::THREE_QUARTERS) {
+				intervalLow -= IntervalTraitsType::QUARTER;
+				intervalHigh -= IntervalTraitsType::QUARTER;
+				value -= IntervalTraitsType::QUARTER;
+			// none of these cases so break loop
+			} else
+				break;
+
+			intervalLow <<= 1;
+			intervalHigh = (intervalHigh << 1) + 1;
+			readBit();
+		}
+	}
 
 	std::shared_ptr<BitStreamReader> bitStreamReader;
 
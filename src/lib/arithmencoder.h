@@ -22,7 +22,7 @@ class ArithmeticEncoder
 {
 public:
 	/// Ctor
-	explicit ArithmeticEncoder(std::shared_ptr<BitStreamWriter>& bsw);
+	explicit ArithmeticEncoder(const std::shared_ptr<BitStreamWriter>& bsw);
 
 	~ArithmeticEncoder() {
 		close();
@@ -32,14 +32,39 @@ public:
 
 	/**
 	 * Finishes encoding, writing last necessary bits.
+	 * Another calls don't write anything until reset.
 	 */
 	void close();
 
 	/**
 	 * Encodes given symbol with data model.
-	 * Result will be stored to data buffer accessible with {@link data} method,
-	 * also {@link writtenBits} counter will be increased by number of bits
-	 * required to store encoded symbol.
+	 * Model type is known at compile time, so its frequency lookups and
+	 * update get inlined. Model must provide totalFreq, lowFreq, highFreq
+	 * and update methods, see StaticDataModel.
+	 * @param symbol symbol from model to encode
+	 * @param model data model with frequencies, it's updated after symbol is coded
+	 */
+	template <class Model>
+	void encode(unsigned symbol, Model& model) {
+		// compute helper value
+		auto range = intervalHigh - intervalLow + 1;
+		auto scale = model.totalFreq();
+
+		// interval upper bound
+		intervalHigh = intervalLow + (range * model.highFreq(symbol)) / scale - 1;
+
+		// interval lower bound is computed as low + (r * cumFreq(i-1)) / s and cumFreq(-1) == 0 so
+		// if symbol == 0 then interval lower bound is not modified 
+		if (symbol != 0)
+			intervalLow += (range * model.lowFreq(symbol)) / scale;
+
+		renormalize();
+		model.update(symbol);
+	}
+
+	/**
+	 * Encodes given symbol with data model of unknown type.
+	 * Only adaptive data models are updated.
 	 * @param symbol symbol from dataModel to encode
 	 * @param dataModel data model with frequencies
 	 */
@@ -51,7 +76,60 @@ public:
 private:
 	typedef IntervalTraits<sizeof(uint32_t)> IntervalTraitsType;
 
-	void encodeIntervalChange(bool flag);
+	void encodeIntervalChange(bool flag) {
+		bitStreamWriter->writeBit(flag);
+
+		// handle third case, we use relation that (C3)^k C1 = C1 (C2)^k,
+		// so counter opposite bits follow, they're written by whole fields
+		uint32_t opposite = flag ? 0U : ~0U;
+		for (; counter >= 32; counter -= 32)
+			bitStreamWriter->writeBits(opposite, 32);
+		if (counter > 0) {
+			bitStreamWriter->writeBits(opposite >> (32 - counter), static_cast<unsigned>(counter));
+			counter = 0;
+		}
+	}
+
+	/// Enlarges interval after symbol was coded and sends info about it to output.
+	void renormalize() {
+		// loop ends when interval is large enough
+		for (;;) {
+			// interval is in lower half of possible range
+			if (intervalHigh < IntervalTraitsType::HALF) {
+				// encode first case as zero
+				encodeIntervalChange(false);
+
+			// interval is in upper half of possible range
+			} else if (intervalLow >= IntervalTraitsType::HALF) {
+				// enlarge interval
+				intervalLow -= IntervalTraitsType::HALF;
+				intervalHigh -= IntervalTraitsType::HALF;
+
+				// encode second case as one
+				encodeIntervalChange(true);
+
+			// interval is in middle of possible range
+			} else if (intervalLow >= IntervalTraitsType::QUARTER && intervalHigh < IntervalTraitsType::THREE_QUARTERS) {
+				// enlarge interval
+				intervalLow -= IntervalTraitsType::QUARTER;
+				intervalHigh -= IntervalTraitsType::QUARTER;
+
+				// this case can't be encoded directly but we can prove that
+				// (C3)^k C1 = C1 (C2)^k and (C3)^k C2 = C2 (C1)^k so we count
+				// third cases in row and than handle them in first and second case using
+				// above formulas
+
+				// increase counter
+				counter++;
+
+			// none of these cases so break loop
+			} else
+				break;
+
+			intervalLow <<= 1;
+			intervalHigh = (intervalHigh << 1) + 1;
+		}
+	}
 
 	std::shared_ptr<BitStreamWriter> bitStreamWriter;
 
@@ -60,6 +138,7 @@ private:
 	/// counter that counts how many times in row was interval enlarged from
 	/// middle possible range
 	std::size_t counter;
+	bool closed;
 };
 
 #endif // !ARITHMENCODER_H
@@ -0,0 +1,131 @@
+/**
+ * @file bitstream.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "bitstream.h"
+
+#include <algorithm>
+
+/// size of block read from or written to stream at once
+static const size_t BLOCK_SIZE = 1 << 16;
+
+BitStreamReader::BitStreamReader(const uint8_t* data, size_t size, EndPolicy policy) : stream(nullptr), policy(policy),
+	next(data), end(data + size), bits(0), count(0), loaded(0), padding(0) { }
+
+BitStreamReader::BitStreamReader(const std::vector<uint8_t>& data, EndPolicy policy) : stream(nullptr), policy(policy),
+	next(data.data()), end(data.data() + data.size()), bits(0), count(0), loaded(0), padding(0) { }
+
+BitStreamReader::BitStreamReader(std::istream* stream, EndPolicy policy) : stream(stream), policy(policy),
+	next(nullptr), end(nullptr), bits(0), count(0), loaded(0), padding(0) { }
+
+void BitStreamReader::refill() {
+	if (next == end && !fillBlock()) {
+		if (policy == EndPolicy::Throw)
+			throw std::runtime_error("Unable to read from stream!");
+
+		// whole word of zeros, it's read same way as data
+		bits = 0;
+		count = 64;
+		padding += 64;
+		return;
+	}
+
+	if (end - next >= 8) {
+		bits = 0;
+		for (int i = 0; i < 8; ++i)
+			bits = (bits << 8) | next[i];
+		next += 8;
+		count = 64;
+	} else {
+		// tail of buffer is shorter than word
+		bits = 0;
+		count = 0;
+		for (; next != end; ++next, count += 8)
+			bits |= static_cast<uint64_t>(*next) << (56 - count);
+	}
+	loaded += count;
+}
+
+uint32_t BitStreamReader::readBitsSlow(unsigned n) {
+	uint64_t value = 0;
+	while (n > 0) {
+		if (count == 0)
+			refill();
+
+		unsigned part = std::min(n, count);
+		value = (value << part) | (bits >> (64 - part));
+		bits <<= part;
+		count -= part;
+		n -= part;
+	}
+	return static_cast<uint32_t>(value);
+}
+
+bool BitStreamReader::fillBlock() {
+	if (stream == nullptr)
+		return false;
+
+	block.resize(BLOCK_SIZE);
+	stream->read(reinterpret_cast<char*>(block.data()), block.size());
+	block.resize(static_cast<size_t>(stream->gcount()));
+	next = block.data();
+	end = next + block.size();
+	return !block.empty();
+}
+
+BitStreamWriter::BitStreamWriter(std::vector<uint8_t>* buffer) : stream(nullptr), buffer(buffer),
+	begin(buffer->data() + buffer->size()), next(begin), end(begin), written(0), bits(0), count(0) { }
+
+BitStreamWriter::BitStreamWriter(uint8_t* data, size_t size) : stream(nullptr), buffer(nullptr),
+	begin(data), next(data), end(data + size), written(0), bits(0), count(0) { }
+
+BitStreamWriter::BitStreamWriter(std::ostream* stream) : stream(stream), buffer(nullptr), block(BLOCK_SIZE),
+	begin(block.data()), next(begin), end(begin + block.size()), written(0), bits(0), count(0) { }
+
+void BitStreamWriter::flush() {
+	// store whole bytes of register, last one is padded by zeros
+	if (count > 0) {
+		size_t numBytes = (count + 7) / 8;
+		if (static_cast<size_t>(end - next) < numBytes)
+			makeSpace();
+
+		uint64_t word = bits << (64 - count);
+		for (size_t i = 0; i < numBytes; ++i, word <<= 8)
+			*next++ = static_cast<uint8_t>(word >> 56);
+		bits = 0;
+		count = 0;
+	}
+
+	if (stream != nullptr)
+		writeBlock();
+	else if (buffer != nullptr) {
+		// vector is cut to written data, shrinking doesn't move it
+		buffer->resize(static_cast<size_t>(next - buffer->data()));
+		end = next;
+	}
+}
+
+void BitStreamWriter::makeSpace() {
+	if (stream != nullptr) {
+		writeBlock();
+	} else if (buffer != nullptr) {
+		auto offset = begin - buffer->data();
+		auto position = next - buffer->data();
+		buffer->resize(std::max<size_t>(2 * buffer->size(), position + BLOCK_SIZE / 16));
+		begin = buffer->data() + offset;
+		next = buffer->data() + position;
+		end = buffer->data() + buffer->size();
+	} else
+		throw std::runtime_error("Bit stream buffer is full!");
+}
+
+void BitStreamWriter::writeBlock() {
+	if (next != begin && !stream->write(reinterpret_cast<const char*>(begin), next - begin))
+		throw std::runtime_error("Unable to put byte into stream!");
+
+	written += static_cast<size_t>(next - begin);
+	next = begin;
+}
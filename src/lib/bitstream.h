@@ -9,120 +9,224 @@
 #define BITSTREAM_H
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <stdexcept>
 
 /**
- * Reader for individual bits from stl streams.
+ * Reader of individual bits and bit fields.
+ * Bits are read from memory buffer by whole 64bit words into register,
+ * so buffer is touched once per 64 bits. Buffer is either given by caller
+ * or it is filled by big blocks from stl stream. Bits are read from most
+ * significant bit of every byte.
+ * Past end of data reader either throws or returns zeros, zeros are
+ * as cheap as any other bits, so truncated streams can be decoded.
  */
 class BitStreamReader
 {
 public:
+	/// What reader does when it gets to end of data
+	enum class EndPolicy { Throw, ZeroFill };
+
 	/**
-	 * Constructs new reader from stream.
-	 * @param stream stl istream
+	 * Constructs new reader of memory buffer.
+	 * @param data buffer with bits, it has to live as long as reader
+	 * @param size size of buffer in bytes
+	 * @param policy behavior past end of buffer
 	 */
-	explicit BitStreamReader(std::istream* stream) {
-		reset(stream);
-	}
+	BitStreamReader(const uint8_t* data, size_t size, EndPolicy policy = EndPolicy::Throw);
+
+	/**
+	 * Constructs new reader of vector contents.
+	 * @param data vector with bits, it mustn't be changed while reader lives
+	 * @param policy behavior past end of vector
+	 */
+	explicit BitStreamReader(const std::vector<uint8_t>& data, EndPolicy policy = EndPolicy::Throw);
 
 	/**
-	 * Resets reader to work on new stream.
-	 * @param stream new istream to read from
+	 * Constructs new reader from stream.
+	 * @param stream stl istream, reader may read from it more than it consumes
+	 * @param policy behavior past end of stream
 	 */
-	void reset(std::istream* stream) {
-		byte = 0;
-		mask = 0;
-		this->stream = stream;
+	explicit BitStreamReader(std::istream* stream, EndPolicy policy = EndPolicy::Throw);
+
+	void setEndPolicy(EndPolicy policy) {
+		this->policy = policy;
+	}
+
+	/// Get number of bits read from data, zeros read past its end aren't counted.
+	size_t consumedBits() const {
+		return std::min(loaded, loaded + padding - count);
+	}
+
+	/// Checks whether reader returned any zeros past end of data.
+	bool pastEnd() const {
+		return loaded + padding - count > loaded;
 	}
 
 	/**
 	 * Read single bit from stream.
 	 * @return true if read bit set false otherwise
-	 * @throws std::runtime_error when unable to read from stream
+	 * @throws std::runtime_error when unable to read from stream and policy is Throw
 	 */
 	bool readBit() {
-		if (mask == 0) {
-			if (!stream->read(reinterpret_cast<char*>(&byte), 1))
-				throw std::runtime_error("Unable to read from stream!");
-			mask = 0x80;
-		}
+		if (count == 0)
+			refill();
 
-		bool bit = !!(byte & mask);
-		mask >>= 1;
+		bool bit = (bits >> 63) != 0;
+		bits <<= 1;
+		count--;
 		return bit;
 	}
+
+	/**
+	 * Reads field of bits, first read bit is most significant.
+	 * @param n number of bits, at most 32
+	 * @return read bits in lowest n bits of result
+	 * @throws std::runtime_error when there are less than n bits and policy is Throw
+	 */
+	uint32_t readBits(unsigned n) {
+		assert(n <= 32);
+		if (n == 0)
+			return 0;
+		if (n > count)
+			return readBitsSlow(n);
+
+		auto value = static_cast<uint32_t>(bits >> (64 - n));
+		bits <<= n;
+		count -= n;
+		return value;
+	}
 private:
-	std::istream* stream;
+	/// Loads next word of buffer to register, zeros past end of data.
+	void refill();
+
+	/// Reads field that crosses words.
+	uint32_t readBitsSlow(unsigned n);
 
-	uint8_t byte;		/// buffer for current byte
-	uint8_t mask;
+	/// Reads next block of stream to buffer, returns false on its end.
+	bool fillBlock();
+
+	std::istream* stream;			/// stream that fills block, null for memory buffers
+	std::vector<uint8_t> block;		/// last block read from stream
+	EndPolicy policy;
+
+	const uint8_t* next;			/// first byte that isn't in register yet
+	const uint8_t* end;
+
+	uint64_t bits;					/// bits not read yet aligned to most significant bit
+	unsigned count;					/// number of valid bits in register
+	size_t loaded;					/// number of bits of data loaded to register
+	size_t padding;					/// number of zeros loaded past end of data
 };
 
 /**
- * Writer for individual bits to stl streams.
+ * Writer of individual bits and bit fields.
+ * Bits are gathered in 64bit register, that is stored to memory as whole.
+ * Bytes are appended to growing vector, written to caller buffer or
+ * written to stl stream by big blocks. Written data are complete after
+ * flush, that is called by destructor too.
  */
 class BitStreamWriter
 {
 public:
+	/**
+	 * Constructs new writer that appends to vector.
+	 * @param buffer vector that grows as needed, it has to live as long as writer
+	 */
+	explicit BitStreamWriter(std::vector<uint8_t>* buffer);
+
+	/**
+	 * Constructs new writer to memory buffer of fixed size.
+	 * @param data buffer for bits, it has to live as long as writer
+	 * @param size size of buffer in bytes
+	 */
+	BitStreamWriter(uint8_t* data, size_t size);
+
 	/**
 	 * Constructs new writer for stream.
 	 * @param stream stl ostream
 	 */
-	explicit BitStreamWriter(std::ostream* stream) {
-		reset(stream);
-	}
+	explicit BitStreamWriter(std::ostream* stream);
 
 	~BitStreamWriter() {
-		flush();
+		// destructor can't report errors, call flush to get them
+		try {
+			flush();
+		} catch (std::exception&) {
+		}
 	}
 
 	/**
 	 * Flushes internal writing buffer.
+	 * Last byte is padded by zeros and following bits start new byte.
+	 * @throws std::runtime_error when failed to write to stream or buffer is full
 	 */
-	void flush() {
-		// when we have something in buffer, write whole byte to stream
-		if (mask != 0x80) {
-			stream->put(byte);
-			byte = 0;
-			mask = 0x80;
-		}
-	}
+	void flush();
 
 	/**
-	 * Resets reader to work on new stream.
-	 * @param stream new ostream to write to
+	 * Writes single bit to stream.
+	 * @param bit true if new bit should be set, false otherwise
+	 * @throws std::runtime_error when failed to write to stream or buffer is full
 	 */
-	void reset(std::ostream* stream) {
-		byte = 0;
-		mask = 0x80;
-		this->stream = stream;
+	void writeBit(bool bit) {
+		writeBits(bit ? 1U : 0U, 1);
 	}
 
 	/**
-	 * Writes single bit to stream.
-	 * @param bit true if new bit should be set, false otherwise
-	 * @throws std::runtime_error when failed to write to stream
+	 * Writes field of bits, most significant bit is written first.
+	 * @param value bits in lowest n bits, higher bits must be zero
+	 * @param n number of bits, at most 32
+	 * @throws std::runtime_error when failed to write to stream or buffer is full
 	 */
-	void writeBit(bool bit) {
-		// set bit if we should
-		if (bit)
-			byte |= mask;
+	void writeBits(uint32_t value, unsigned n) {
+		assert(n <= 32 && (n == 32 || (value >> n) == 0));
+		unsigned space = 64 - count;
+		if (n < space) {
+			bits = (bits << n) | value;
+			count += n;
+			return;
+		}
 
-		mask >>= 1;
-		if (mask == 0) {
-			if (!stream->put(byte))
-				throw std::runtime_error("Unable to put byte into stream!");
+		// fill register up and store it, rest of field starts new word
+		unsigned rest = n - space;
+		storeWord((bits << space) | (static_cast<uint64_t>(value) >> rest));
+		bits = value & ((static_cast<uint64_t>(1) << rest) - 1);
+		count = rest;
+	}
 
-			byte = 0;
-			mask = 0x80;
-		}
+	/// Get number of bytes written, last byte counts only after flush.
+	size_t size() const {
+		return written + static_cast<size_t>(next - begin);
 	}
 private:
-	std::ostream* stream;
+	void storeWord(uint64_t word) {
+		if (end - next < 8)
+			makeSpace();
+
+		for (int shift = 56; shift >= 0; shift -= 8)
+			*next++ = static_cast<uint8_t>(word >> shift);
+	}
+
+	/// Makes space for at least one word, writes block to stream or grows vector.
+	void makeSpace();
+
+	/// Writes block to stream.
+	void writeBlock();
+
+	std::ostream* stream;			/// stream written by blocks, null when writing to memory
+	std::vector<uint8_t>* buffer;	/// growing vector, null for fixed buffer and stream
+	std::vector<uint8_t> block;		/// block waiting for write to stream
+
+	uint8_t* begin;					/// start of memory that is being written
+	uint8_t* next;					/// position of next byte
+	uint8_t* end;
+	size_t written;					/// bytes already written to stream
 
-	uint8_t byte;
-	uint8_t mask;
+	uint64_t bits;					/// register with bits not stored yet
+	unsigned count;					/// number of bits in register
 };
 
 #endif // !BITSTREAM_H
@@ -0,0 +1,86 @@
+/**
+ * @file boundedqueue.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+/**
+ * Queue of limited capacity connecting stages of pipeline.
+ * Producers wait while queue is full, so they can't get far ahead of
+ * consumers, and consumers wait while it is empty. Closed queue accepts
+ * no more items, consumers get items left in it and then end.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+	/**
+	 * Creates empty queue.
+	 * @param capacity maximal number of items in queue, at least one
+	 */
+	explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1), closed(false) { }
+
+	/**
+	 * Appends item, waits while queue is full.
+	 * @return false when queue was closed and item wasn't appended
+	 */
+	bool push(T item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] () { return closed || items.size() < capacity; });
+		if (closed)
+			return false;
+
+		items.push_back(std::move(item));
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+
+	/**
+	 * Takes first item, waits while queue is empty.
+	 * @return false when queue is closed and there are no items left
+	 */
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] () { return closed || !items.empty(); });
+		if (items.empty())
+			return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+		lock.unlock();
+		notFull.notify_one();
+		return true;
+	}
+
+	/// Ends queue, waiting producers and consumers are woken up.
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		notFull.notify_all();
+		notEmpty.notify_all();
+	}
+private:
+	BoundedQueue(const BoundedQueue&);
+	BoundedQueue& operator=(const BoundedQueue&);
+
+	std::deque<T> items;
+	size_t capacity;
+	bool closed;
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+};
+
+#endif // !BOUNDED_QUEUE_H
@@ -6,66 +6,46 @@
  */
 
 #include "cdf53wavelet.h"
+#include "liftingkernels.h"
 
 #include <cassert>
 
-void Cdf53Wavelet::forward(ArrayRef<int32_t> signal) {
-	assert(signal.size() % 2 == 0);
-
-	// predict
-	for (size_t i = 1; i < signal.size() - 2; i += 2) {
-		signal[i] -= (signal[i - 1] + signal[i + 1]) >> 1;
-	}
-	// symmetric extension
-	signal[signal.size() - 1] -= (2 * signal[signal.size() - 2]) >> 1;
+Cdf53Wavelet::Cdf53Wavelet(SimdLevel simd) : simd(clampSimdLevel(simd)) {
+	// integer kernels need sse4.1 at least
+	if (this->simd == SimdLevel::Sse2)
+		this->simd = SimdLevel::None;
+}
 
-	// update
-	for (size_t i = 2; i < signal.size(); i += 2) {
-		signal[i] += (signal[i - 1] + signal[i + 1] + 2) >> 2;
-	}
-	// symmetric extension
-	signal[0] += (2 * signal[1] + 2) >> 2;
+void Cdf53Wavelet::forward(ArrayRef<int32_t> signal, ArrayRef<int32_t> scratch) const {
+	assert(signal.size() % 2 == 0);
 
-	// deinterleave to tempbank
-	tempbank.resize(signal.size());
-	for (size_t i = 0; i < signal.size(); ++i) {
-		if (i % 2) {
-			tempbank[i / 2 + signal.size() / 2] = signal[i];
-		} else {
-			tempbank[i / 2] = signal[i];
-		}
+#ifdef WAVELET_SIMD_X86
+	if (simd >= SimdLevel::Sse41) {
+		assert(scratch.size() >= signal.size() / 2);
+		if (simd >= SimdLevel::Avx2)
+			cdf53ForwardAvx2(signal.data(), scratch.data(), signal.size());
+		else
+			cdf53ForwardSse41(signal.data(), scratch.data(), signal.size());
+		return;
 	}
+#endif
 
-	for (size_t i = 0; i < signal.size(); i++) {
-		signal[i] = tempbank[i];
-	}
+	LiftingWavelet<Cdf53Scheme>::forward(signal, scratch);
 }
 
-void Cdf53Wavelet::inverse(ArrayRef<int32_t> dwt) {
+void Cdf53Wavelet::inverse(ArrayRef<int32_t> dwt, ArrayRef<int32_t> scratch) const {
 	assert(dwt.size() % 2 == 0);
 
-	// interleave coefs
-	tempbank.resize(dwt.size());
-	for (size_t i = 0; i < dwt.size() / 2; i++) {
-		tempbank[i * 2] = dwt[i];
-		tempbank[i * 2 + 1] = dwt[i + dwt.size() / 2];
+#ifdef WAVELET_SIMD_X86
+	if (simd >= SimdLevel::Sse41) {
+		assert(scratch.size() >= dwt.size() / 2);
+		if (simd >= SimdLevel::Avx2)
+			cdf53InverseAvx2(dwt.data(), scratch.data(), dwt.size());
+		else
+			cdf53InverseSse41(dwt.data(), scratch.data(), dwt.size());
+		return;
 	}
+#endif
 
-	for (size_t i = 0; i < dwt.size(); i++) {
-		dwt[i] = tempbank[i];
-	}
-
-	// undo update
-	for (size_t i = 2; i < dwt.size(); i += 2) {
-		dwt[i] -= (dwt[i - 1] + dwt[i + 1] + 2) >> 2;
-	}
-	// symmetric extension
-	dwt[0] -= (2 * dwt[1] + 2) >> 2;
-
-	// undo predict
-	for (size_t i = 1; i < dwt.size() - 2; i += 2) {
-		dwt[i] += (dwt[i - 1] + dwt[i + 1]) >> 1;
-	}
-	// symmetric extension
-	dwt[dwt.size() - 1] += (2 * dwt[dwt.size() - 2]) >> 1;
-}
\ No newline at end of file
+	LiftingWavelet<Cdf53Scheme>::inverse(dwt, scratch);
+}
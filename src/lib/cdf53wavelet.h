@@ -8,22 +8,62 @@
 #ifndef CDF53_WAVELET_H
 #define CDF53_WAVELET_H
 
-#include "wavelet.h"
+#include "liftingwavelet.h"
+#include "cpufeatures.h"
 
 #include <cstdint>
 
+/// Cdf 5/3 predict: odd -= (even[i] + even[i + 1]) / 2
+struct Cdf53Predict
+{
+	static int32_t delta(int32_t, int32_t b, int32_t c, int32_t) {
+		return -((b + c) >> 1);
+	}
+};
+
+/// Cdf 5/3 update: even += (odd[i - 1] + odd[i] + 2) / 4
+struct Cdf53Update
+{
+	static int32_t delta(int32_t, int32_t b, int32_t c, int32_t) {
+		return (b + c + 2) >> 2;
+	}
+};
+
+/// Cdf 5/3 integer lifting scheme
+struct Cdf53Scheme : LiftingSteps<Cdf53Predict, Cdf53Update>
+{
+	typedef int32_t value_type;
+	typedef NoScaling Scaling;
+};
+
 /**
  * Biorthogonal Cohen-Daubechies-Feauveau 5/3 wavelet AKA Le-Gall 5/3.
- * Lifting integer implementation
+ * Lifting integer implementation, with vectorized kernels for cpus that
+ * support them. Vectorized kernels give bit exact results with scalar ones.
  */
-class Cdf53Wavelet : public Wavelet<int32_t>
+class Cdf53Wavelet : public LiftingWavelet<Cdf53Scheme>
 {
 public:
-	virtual void forward(ArrayRef<int32_t> signal);
+	/**
+	 * Constructs wavelet.
+	 * @param simd highest instruction set that may be used, it's clamped to
+	 *     what running cpu supports. SimdLevel::None forces scalar code.
+	 */
+	explicit Cdf53Wavelet(SimdLevel simd = SimdLevel::Avx2);
+
+	using LiftingWavelet<Cdf53Scheme>::forward;
+	using LiftingWavelet<Cdf53Scheme>::inverse;
+
+	virtual void forward(ArrayRef<int32_t> signal, ArrayRef<int32_t> scratch) const;
+
+	virtual void inverse(ArrayRef<int32_t> dwt, ArrayRef<int32_t> scratch) const;
 
-	virtual void inverse(ArrayRef<int32_t> dwt);
+	/// Get instruction set of kernels actually used by this wavelet.
+	SimdLevel simdLevel() const {
+		return simd;
+	}
 private:
-	std::vector<int32_t> tempbank;		// temp buffer for de/interleaving signal
+	SimdLevel simd;
 };
 
 #endif // !CDF53_WAVELET_H
@@ -8,26 +8,73 @@
 #ifndef CDF97_WAVELET_H
 #define CDF97_WAVELET_H
 
-#include "wavelet.h"
+#include "liftingwavelet.h"
+#include "cpufeatures.h"
 
-#include <vector>
+/// Cdf 9/7 lifting coeficients
+struct Cdf97Coefs
+{
+	static float alpha() { return -1.586134342060f; }
+	static float beta() { return -0.052980118573f; }
+	static float gamma() { return 0.882911075531f; }
+	static float delta() { return 0.443506852044f; }
+	static float zeta() { return 1.149604398860f; }
+};
+
+/// Lifting step target += Coef * (b + c) with coeficient given by function
+template <float (*Coef)()>
+struct Cdf97Step
+{
+	static float delta(float, float b, float c, float) {
+		return Coef() * (b + c);
+	}
+};
+
+/// Scales approx coefs by zeta and detail coefs by 1 / zeta
+struct Cdf97Scaling
+{
+	static float approx(float even) { return even / (1.0f / Cdf97Coefs::zeta()); }
+	static float detail(float odd) { return odd * (1.0f / Cdf97Coefs::zeta()); }
+	static float even(float approx) { return approx / Cdf97Coefs::zeta(); }
+	static float odd(float detail) { return detail * Cdf97Coefs::zeta(); }
+};
+
+/// Cdf 9/7 lifting scheme, two predicts and two updates
+struct Cdf97Scheme : LiftingSteps<Cdf97Step<Cdf97Coefs::alpha>, Cdf97Step<Cdf97Coefs::beta>,
+	Cdf97Step<Cdf97Coefs::gamma>, Cdf97Step<Cdf97Coefs::delta>>
+{
+	typedef float value_type;
+	typedef Cdf97Scaling Scaling;
+};
 
 /**
  * Biorthogonal Cohen-Daubechies-Feauveau 9/7 wavelet.
- * Lifting implementation
+ * Lifting implementation, with vectorized kernels for cpus that support them.
  */
-class Cdf97Wavelet : public Wavelet<float>
+class Cdf97Wavelet : public LiftingWavelet<Cdf97Scheme>
 {
 public:
-	virtual void forward(ArrayRef<float> signal);
+	/**
+	 * Constructs wavelet.
+	 * @param simd highest instruction set that may be used, it's clamped to
+	 *     what running cpu supports. SimdLevel::None forces scalar code.
+	 */
+	explicit Cdf97Wavelet(SimdLevel simd = SimdLevel::Avx2);
 
-	virtual void inverse(ArrayRef<float> dwt);
-private:
-	static void liftPredict(ArrayRef<float> signal, float coef);
-	static void liftUpdate(ArrayRef<float> signal, float coef);
+	using LiftingWavelet<Cdf97Scheme>::forward;
+	using LiftingWavelet<Cdf97Scheme>::inverse;
 
-	static float coefs[];				// lifting coeficients
-	std::vector<float> tempbank;		// temp buffer for de/interleaving signal
+	virtual void forward(ArrayRef<float> signal, ArrayRef<float> scratch) const;
+
+	virtual void inverse(ArrayRef<float> dwt, ArrayRef<float> scratch) const;
+
+	/// Get instruction set of kernels actually used by this wavelet.
+	SimdLevel simdLevel() const {
+		return simd;
+	}
+private:
+	static const float coefs[];			// lifting coeficients for vectorized kernels
+	SimdLevel simd;
 };
 
 #endif // !CDF97_WAVELET_H
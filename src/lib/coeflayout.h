@@ -0,0 +1,161 @@
+/**
+ * @file coeflayout.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef COEF_LAYOUT_H
+#define COEF_LAYOUT_H
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+
+/// Order in which zerotree coders keep coefs in memory
+enum class CoefLayout { RowMajor, Morton };
+
+/**
+ * Row major order of continuous cv::Mat.
+ * Zerotree coders give children of coef x, y coordinates 2x .. 2x + 1,
+ * 2y .. 2y + 1, so only coefs in upper left quarter have children.
+ * Layouts address those by treeIndex in separate, quarter sized arrays.
+ */
+struct RowMajorLayout
+{
+	typedef uint32_t Index;
+
+	RowMajorLayout(size_t cols, size_t rows) : cols(cols), rows(rows) { }
+
+	Index index(size_t x, size_t y) const {
+		return static_cast<Index>(y * cols + x);
+	}
+
+	Index treeIndex(size_t x, size_t y) const {
+		return static_cast<Index>(y * (cols / 2) + x);
+	}
+
+	size_t x(Index index) const {
+		return index % cols;
+	}
+
+	size_t y(Index index) const {
+		return index / cols;
+	}
+
+	/// Get number of values that array in this layout needs.
+	size_t size() const {
+		return cols * rows;
+	}
+
+	/// Get number of values that array indexed by treeIndex needs.
+	size_t treeSize() const {
+		return (cols / 2) * (rows / 2);
+	}
+
+	size_t cols, rows;
+};
+
+/**
+ * Morton (Z) order, index interleaves bits of x (even bits) and y (odd bits).
+ * Children of coef with index i are at 4i .. 4i + 3, so every subtree lies
+ * in contiguous block and tree traversal reads memory sequentially.
+ * Matrix that isn't square with power of two size leaves holes in array,
+ * coders never touch them.
+ */
+struct MortonLayout
+{
+	typedef uint32_t Index;
+
+	/// width and height must be lower, size of bigger matrix doesn't fit to 32 bits
+	static const size_t MAX_SIZE = 1 << 16;
+
+	MortonLayout(size_t cols, size_t rows) : cols(cols), rows(rows) {
+		if (cols >= MAX_SIZE || rows >= MAX_SIZE)
+			throw std::runtime_error("MortonLayout: matrix is too big!");
+	}
+
+	Index index(size_t x, size_t y) const {
+		return spread(static_cast<uint32_t>(x)) | (spread(static_cast<uint32_t>(y)) << 1);
+	}
+
+	Index treeIndex(size_t x, size_t y) const {
+		return index(x, y);
+	}
+
+	size_t x(Index index) const {
+		return compact(index);
+	}
+
+	size_t y(Index index) const {
+		return compact(index >> 1);
+	}
+
+	size_t size() const {
+		return cols != 0 && rows != 0 ? static_cast<size_t>(index(cols - 1, rows - 1)) + 1 : 0;
+	}
+
+	size_t treeSize() const {
+		return cols >= 2 && rows >= 2 ? static_cast<size_t>(index(cols / 2 - 1, rows / 2 - 1)) + 1 : 0;
+	}
+
+	/// Moves lower 16 bits of v to even bits.
+	static uint32_t spread(uint32_t v) {
+		v &= 0x0000ffff;
+		v = (v | (v << 8)) & 0x00ff00ff;
+		v = (v | (v << 4)) & 0x0f0f0f0f;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	/// Moves even bits of v to lower 16 bits, inverse of spread.
+	static uint32_t compact(uint32_t v) {
+		v &= 0x55555555;
+		v = (v | (v >> 1)) & 0x33333333;
+		v = (v | (v >> 2)) & 0x0f0f0f0f;
+		v = (v | (v >> 4)) & 0x00ff00ff;
+		v = (v | (v >> 8)) & 0x0000ffff;
+		return v;
+	}
+
+	size_t cols, rows;
+};
+
+/**
+ * Get layout for matrix of given size. Morton layout is used when matrix
+ * fits to it and its holes take at most as much memory as coefs, so long
+ * and narrow matrices stay in row major order.
+ */
+inline CoefLayout preferredLayout(size_t cols, size_t rows) {
+	if (cols >= MortonLayout::MAX_SIZE || rows >= MortonLayout::MAX_SIZE)
+		return CoefLayout::RowMajor;
+
+	return MortonLayout(cols, rows).size() <= 2 * cols * rows ? CoefLayout::Morton : CoefLayout::RowMajor;
+}
+
+/// Copies CV_32S matrix to array in given layout, holes are zero.
+template <class Layout>
+void toLayout(const cv::Mat& m, const Layout& layout, std::vector<int32_t>& result) {
+	result.assign(layout.size(), 0);
+	for (int y = 0; y < m.rows; ++y) {
+		const int32_t* row = m.ptr<int32_t>(y);
+		for (int x = 0; x < m.cols; ++x)
+			result[layout.index(x, y)] = row[x];
+	}
+}
+
+/// Copies array in given layout back to CV_32S matrix.
+template <class Layout>
+void fromLayout(const std::vector<int32_t>& coefs, const Layout& layout, cv::Mat& m) {
+	for (int y = 0; y < m.rows; ++y) {
+		int32_t* row = m.ptr<int32_t>(y);
+		for (int x = 0; x < m.cols; ++x)
+			row[x] = coefs[layout.index(x, y)];
+	}
+}
+
+#endif // !COEF_LAYOUT_H
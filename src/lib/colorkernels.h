@@ -0,0 +1,46 @@
+/**
+ * @file colorkernels.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef COLOR_KERNELS_H
+#define COLOR_KERNELS_H
+
+#include <cstdint>
+
+/// fixed point coefficients of OpenCV color conversions, they are scaled by 2^COLOR_SHIFT
+static const int COLOR_SHIFT = 14;
+static const int R2Y = 4899, G2Y = 9617, B2Y = 1868, YCRI = 11682, YCBI = 9241;
+static const int CR2RI = 22987, CR2GI = -11698, CB2GI = -5636, CB2BI = 29049;
+static const int CHROMA_DELTA = 128;
+
+// Vectorized row kernels of ycbcr planes. Like lifting kernels they live in
+// translation unit compiled with flags of their instruction set, so these may
+// be called only after checking detectSimdLevel() and only when library was
+// built with WAVELET_SIMD_X86 defined.
+//
+// Kernels process leading pixels of row in groups and return number of
+// processed pixels, caller finishes rest of row by scalar code. Results are
+// bit exact with scalar code in colorplanes.cpp. When subsampled is true,
+// chroma sample i belongs to pixels 2i and 2i + 1.
+
+/**
+ * Transforms bgr pixels to luma and chroma samples.
+ * @param cols number of pixels in row
+ */
+int splitYCbCrSse2(const uint8_t* bgr, int cols, bool subsampled, float* luma, float* cr, float* cb);
+int splitYCbCrSse2(const uint8_t* bgr, int cols, bool subsampled, int32_t* luma, int32_t* cr, int32_t* cb);
+
+/**
+ * Scales and rounds luma and chroma samples to 8bits and transforms them to bgr pixels.
+ * @param cols number of pixels in row
+ * @param chromaCols number of chroma samples in row
+ */
+int mergeYCbCrSse2(const float* luma, const float* cr, const float* cb, int cols, int chromaCols, bool subsampled,
+	float scale, uint8_t* bgr);
+int mergeYCbCrSse2(const int32_t* luma, const int32_t* cr, const int32_t* cb, int cols, int chromaCols, bool subsampled,
+	float scale, uint8_t* bgr);
+
+#endif // !COLOR_KERNELS_H
@@ -0,0 +1,284 @@
+/**
+ * @file colorplanes.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "colorplanes.h"
+#include "colorkernels.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+typedef WlfImage::PixelFormat::Type PixelType;
+
+static inline int descale(int x) {
+	return (x + (1 << (COLOR_SHIFT - 1))) >> COLOR_SHIFT;
+}
+
+static inline int saturate(int x) {
+	return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+static inline int luma(int b, int g, int r) {
+	return descale(b * B2Y + g * G2Y + r * R2Y);
+}
+
+static inline int chroma(int value, int y, int coef) {
+	return saturate(descale((value - y) * coef) + CHROMA_DELTA);
+}
+
+/// Scales and rounds plane value to 8bits same way as convertTo does.
+template <typename T>
+static inline int toByte(T value, float scale) {
+	float scaled = static_cast<float>(value) * scale;
+	if (scaled <= 0.0f)
+		return 0;
+	if (scaled >= 255.0f)
+		return 255;
+	return cvRound(scaled);
+}
+
+template <typename T>
+static void splitRgb(const cv::Mat& bgr, std::vector<cv::Mat>& planes) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		const uint8_t* src = bgr.ptr<uint8_t>(y);
+		T* red = planes[0].ptr<T>(y);
+		T* green = planes[1].ptr<T>(y);
+		T* blue = planes[2].ptr<T>(y);
+		for (int x = 0; x < bgr.cols; ++x, src += 3) {
+			red[x] = static_cast<T>(src[2]);
+			green[x] = static_cast<T>(src[1]);
+			blue[x] = static_cast<T>(src[0]);
+		}
+	}
+}
+
+template <typename T>
+static void splitGray(const cv::Mat& bgr, std::vector<cv::Mat>& planes) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		const uint8_t* src = bgr.ptr<uint8_t>(y);
+		T* gray = planes[0].ptr<T>(y);
+		for (int x = 0; x < bgr.cols; ++x, src += 3)
+			gray[x] = static_cast<T>(luma(src[0], src[1], src[2]));
+	}
+}
+
+template <typename T>
+static void splitYCbCr444(const cv::Mat& bgr, std::vector<cv::Mat>& planes, SimdLevel simd) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		const uint8_t* src = bgr.ptr<uint8_t>(y);
+		T* lumaRow = planes[0].ptr<T>(y);
+		T* cr = planes[1].ptr<T>(y);
+		T* cb = planes[2].ptr<T>(y);
+
+		int x = 0;
+#ifdef WAVELET_SIMD_X86
+		if (simd >= SimdLevel::Sse2)
+			x = splitYCbCrSse2(src, bgr.cols, false, lumaRow, cr, cb);
+#endif
+		for (src += 3 * x; x < bgr.cols; ++x, src += 3) {
+			int lum = luma(src[0], src[1], src[2]);
+			lumaRow[x] = static_cast<T>(lum);
+			cr[x] = static_cast<T>(chroma(src[2], lum, YCRI));
+			cb[x] = static_cast<T>(chroma(src[0], lum, YCBI));
+		}
+	}
+}
+
+/// Chroma is taken from even columns, as nearest neighbour resize does.
+template <typename T>
+static void splitYCbCr422(const cv::Mat& bgr, std::vector<cv::Mat>& planes, SimdLevel simd) {
+	int chromaCols = planes[1].cols;
+	for (int y = 0; y < bgr.rows; ++y) {
+		const uint8_t* src = bgr.ptr<uint8_t>(y);
+		T* lumaRow = planes[0].ptr<T>(y);
+		T* cr = planes[1].ptr<T>(y);
+		T* cb = planes[2].ptr<T>(y);
+
+		// kernel processes groups of 4 columns, so it always ends at start of pair
+		int x = 0;
+#ifdef WAVELET_SIMD_X86
+		if (simd >= SimdLevel::Sse2)
+			x = splitYCbCrSse2(src, bgr.cols, true, lumaRow, cr, cb);
+#endif
+
+		// pairs of columns share chroma sample
+		src += 3 * x;
+		for (int c = x / 2; c < chromaCols; ++c, src += 6) {
+			int lum = luma(src[0], src[1], src[2]);
+			lumaRow[2 * c] = static_cast<T>(lum);
+			lumaRow[2 * c + 1] = static_cast<T>(luma(src[3], src[4], src[5]));
+			cr[c] = static_cast<T>(chroma(src[2], lum, YCRI));
+			cb[c] = static_cast<T>(chroma(src[0], lum, YCBI));
+		}
+
+		// last column of odd width has no chroma sample
+		for (x = 2 * chromaCols; x < bgr.cols; ++x, src += 3)
+			lumaRow[x] = static_cast<T>(luma(src[0], src[1], src[2]));
+	}
+}
+
+template <typename T>
+static void splitPlanes(PixelType pf, const cv::Mat& bgr, std::vector<cv::Mat>& planes, SimdLevel simd) {
+	switch (pf) {
+	case PixelType::RGB:
+		splitRgb<T>(bgr, planes);
+		break;
+	case PixelType::Gray:
+		splitGray<T>(bgr, planes);
+		break;
+	case PixelType::YCbCr444:
+		splitYCbCr444<T>(bgr, planes, simd);
+		break;
+	case PixelType::YCbCr422:
+		splitYCbCr422<T>(bgr, planes, simd);
+		break;
+	}
+}
+
+void splitToPlanes(PixelType pf, const cv::Mat& bgr, int type, std::vector<cv::Mat>& planes, SimdLevel simd) {
+	if (bgr.type() != CV_8UC3)
+		throw std::runtime_error("Image must have 8bit bgr pixels!");
+
+	int numPlanes = pf == PixelType::Gray ? 1 : 3;
+	int chromaCols = pf == PixelType::YCbCr422 ? bgr.cols / 2 : bgr.cols;
+	planes.resize(numPlanes);
+	for (int i = 0; i < numPlanes; ++i)
+		planes[i].create(bgr.rows, i > 0 ? chromaCols : bgr.cols, type);
+
+	simd = clampSimdLevel(simd);
+	if (type == CV_32F)
+		splitPlanes<float>(pf, bgr, planes, simd);
+	else if (type == CV_32S)
+		splitPlanes<int32_t>(pf, bgr, planes, simd);
+	else
+		throw std::runtime_error("Unsupported type of planes!");
+}
+
+template <typename T>
+static void mergeRgb(const std::vector<cv::Mat>& planes, float scale, cv::Mat& bgr) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		uint8_t* dst = bgr.ptr<uint8_t>(y);
+		const T* red = planes[0].ptr<T>(y);
+		const T* green = planes[1].ptr<T>(y);
+		const T* blue = planes[2].ptr<T>(y);
+		for (int x = 0; x < bgr.cols; ++x, dst += 3) {
+			dst[0] = static_cast<uint8_t>(toByte(blue[x], scale));
+			dst[1] = static_cast<uint8_t>(toByte(green[x], scale));
+			dst[2] = static_cast<uint8_t>(toByte(red[x], scale));
+		}
+	}
+}
+
+template <typename T>
+static void mergeGray(const std::vector<cv::Mat>& planes, float scale, cv::Mat& bgr) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		uint8_t* dst = bgr.ptr<uint8_t>(y);
+		const T* gray = planes[0].ptr<T>(y);
+		for (int x = 0; x < bgr.cols; ++x, dst += 3)
+			dst[0] = dst[1] = dst[2] = static_cast<uint8_t>(toByte(gray[x], scale));
+	}
+}
+
+/// Transforms luma and chroma differences of pixel to bgr.
+static inline void storeBgr(int lum, int crDiff, int cbDiff, uint8_t* dst) {
+	dst[0] = static_cast<uint8_t>(saturate(lum + descale(cbDiff * CB2BI)));
+	dst[1] = static_cast<uint8_t>(saturate(lum + descale(cbDiff * CB2GI + crDiff * CR2GI)));
+	dst[2] = static_cast<uint8_t>(saturate(lum + descale(crDiff * CR2RI)));
+}
+
+template <typename T>
+static void mergeYCbCr444(const std::vector<cv::Mat>& planes, float scale, cv::Mat& bgr, SimdLevel simd) {
+	for (int y = 0; y < bgr.rows; ++y) {
+		uint8_t* dst = bgr.ptr<uint8_t>(y);
+		const T* lumaRow = planes[0].ptr<T>(y);
+		const T* cr = planes[1].ptr<T>(y);
+		const T* cb = planes[2].ptr<T>(y);
+
+		int x = 0;
+#ifdef WAVELET_SIMD_X86
+		if (simd >= SimdLevel::Sse2)
+			x = mergeYCbCrSse2(lumaRow, cr, cb, bgr.cols, bgr.cols, false, scale, dst);
+#endif
+		for (dst += 3 * x; x < bgr.cols; ++x, dst += 3)
+			storeBgr(toByte(lumaRow[x], scale), toByte(cr[x], scale) - CHROMA_DELTA, toByte(cb[x], scale) - CHROMA_DELTA, dst);
+	}
+}
+
+/**
+ * Merges columns from, ..., to - 1 of YCbCr422 row.
+ * Every chroma sample is converted once for pair of columns that share it.
+ */
+template <typename T>
+static void mergeYCbCr422Columns(const T* lumaRow, const T* cr, const T* cb, int lastChroma, int chromaOffset, float scale,
+	int from, int to, uint8_t* dst) {
+	// column x takes chroma sample (x + chromaOffset) / 2, columns past last sample take last one
+	dst += 3 * from;
+	for (int x = from; x < to;) {
+		int c = (x + chromaOffset) / 2;
+		int sample = std::min(c, lastChroma);
+		int crDiff = toByte(cr[sample], scale) - CHROMA_DELTA;
+		int cbDiff = toByte(cb[sample], scale) - CHROMA_DELTA;
+		for (int end = std::min(2 * (c + 1) - chromaOffset, to); x < end; ++x, dst += 3)
+			storeBgr(toByte(lumaRow[x], scale), crDiff, cbDiff, dst);
+	}
+}
+
+template <typename T>
+static void mergeYCbCr422(const std::vector<cv::Mat>& planes, float scale, int chromaOffset, cv::Mat& bgr, SimdLevel simd) {
+	int chromaCols = planes[1].cols;
+	for (int y = 0; y < bgr.rows; ++y) {
+		uint8_t* dst = bgr.ptr<uint8_t>(y);
+		const T* lumaRow = planes[0].ptr<T>(y);
+		const T* cr = planes[1].ptr<T>(y);
+		const T* cb = planes[2].ptr<T>(y);
+
+		int x = 0;
+#ifdef WAVELET_SIMD_X86
+		if (simd >= SimdLevel::Sse2 && bgr.cols > chromaOffset) {
+			// first column of odd offset has chroma sample alone, kernel starts at next pair
+			mergeYCbCr422Columns(lumaRow, cr, cb, chromaCols - 1, chromaOffset, scale, 0, chromaOffset, dst);
+			x = chromaOffset + mergeYCbCrSse2(lumaRow + chromaOffset, cr + chromaOffset, cb + chromaOffset,
+				bgr.cols - chromaOffset, chromaCols - chromaOffset, true, scale, dst + 3 * chromaOffset);
+		}
+#endif
+		mergeYCbCr422Columns(lumaRow, cr, cb, chromaCols - 1, chromaOffset, scale, x, bgr.cols, dst);
+	}
+}
+
+template <typename T>
+static void mergePlanes(PixelType pf, const std::vector<cv::Mat>& planes, float scale, int chromaOffset, cv::Mat& bgr,
+	SimdLevel simd) {
+	switch (pf) {
+	case PixelType::RGB:
+		mergeRgb<T>(planes, scale, bgr);
+		break;
+	case PixelType::Gray:
+		mergeGray<T>(planes, scale, bgr);
+		break;
+	case PixelType::YCbCr444:
+		mergeYCbCr444<T>(planes, scale, bgr, simd);
+		break;
+	case PixelType::YCbCr422:
+		mergeYCbCr422<T>(planes, scale, chromaOffset, bgr, simd);
+		break;
+	}
+}
+
+void mergeFromPlanes(PixelType pf, const std::vector<cv::Mat>& planes, double scale, int chromaOffset, cv::Mat& bgr,
+	SimdLevel simd) {
+	if (bgr.type() != CV_8UC3 || planes.size() != (pf == PixelType::Gray ? 1u : 3u) || planes[0].size() != bgr.size())
+		throw std::runtime_error("Planes don't match image!");
+
+	int type = planes[0].type();
+	simd = clampSimdLevel(simd);
+	if (type == CV_32F)
+		mergePlanes<float>(pf, planes, static_cast<float>(scale), chromaOffset, bgr, simd);
+	else if (type == CV_32S)
+		mergePlanes<int32_t>(pf, planes, static_cast<float>(scale), chromaOffset, bgr, simd);
+	else
+		throw std::runtime_error("Unsupported type of planes!");
+}
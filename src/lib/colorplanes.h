@@ -0,0 +1,51 @@
+/**
+ * @file colorplanes.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef COLOR_PLANES_H
+#define COLOR_PLANES_H
+
+#include "wlfimage.h"
+#include "cpufeatures.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+/**
+ * Splits bgr image to planes of pixel format in single pass.
+ * Color transform, chroma subsampling and conversion to wavelet type are
+ * done at once per pixel. Colors are transformed by fixed point
+ * coefficients of OpenCV, so planes hold values within one level of those
+ * that cvtColor, split, nearest neighbour resize and convertTo would produce.
+ * @param pf pixel format of planes
+ * @param bgr image with 8bit bgr pixels
+ * @param type type of planes, CV_32F or CV_32S
+ * @param planes output planes, chroma planes of YCbCr422 have half width
+ * @param simd highest instruction set that may be used, it's clamped to
+ *     what running cpu supports. SimdLevel::None forces scalar code.
+ * @throws std::runtime_error when image isn't 8bit bgr or type isn't supported
+ */
+void splitToPlanes(WlfImage::PixelFormat::Type pf, const cv::Mat& bgr, int type, std::vector<cv::Mat>& planes,
+	SimdLevel simd = SimdLevel::Avx2);
+
+/**
+ * Merges planes of pixel format to bgr image in single pass.
+ * Planes are scaled, rounded to 8bits, chroma is upsampled and colors
+ * transformed to bgr at once per pixel. It's mirror of splitToPlanes.
+ * @param pf pixel format of planes
+ * @param planes planes of type CV_32F or CV_32S, first one has size of bgr
+ * @param scale factor applied to plane values before rounding
+ * @param chromaOffset 1 when first column of bgr shares chroma sample with
+ *     column before it, it's used by YCbCr422 only
+ * @param bgr output image with 8bit bgr pixels, it must be allocated
+ * @param simd highest instruction set that may be used, see splitToPlanes
+ * @throws std::runtime_error when planes or image have wrong type
+ */
+void mergeFromPlanes(WlfImage::PixelFormat::Type pf, const std::vector<cv::Mat>& planes, double scale, int chromaOffset,
+	cv::Mat& bgr, SimdLevel simd = SimdLevel::Avx2);
+
+#endif // !COLOR_PLANES_H
@@ -0,0 +1,190 @@
+/**
+ * @file colorsse2.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "colorkernels.h"
+
+#ifdef WAVELET_SIMD_X86
+
+#include <emmintrin.h>
+
+#include <cstring>
+
+// Kernels work on 4 pixels held as 32bit lanes. Sse2 has no 32bit multiply,
+// so fixed point sums are computed by _mm_madd_epi16 from pairs of 16bit
+// values, rounding constant of descale is added as second member of pair.
+// Pixels are loaded and stored by 4 byte accesses, last one touches first
+// byte of next pixel, so kernels stop one pixel before end of row.
+
+namespace {
+
+/// Broadcasts pair of 16bit coefficients to every 32bit lane.
+inline __m128i coefPair(int lo, int hi) {
+	return _mm_setr_epi16(static_cast<int16_t>(lo), static_cast<int16_t>(hi), static_cast<int16_t>(lo),
+		static_cast<int16_t>(hi), static_cast<int16_t>(lo), static_cast<int16_t>(hi), static_cast<int16_t>(lo),
+		static_cast<int16_t>(hi));
+}
+
+/// Packs 32bit lanes of lo and hi, which fit to 16bits, to pairs for _mm_madd_epi16.
+inline __m128i valuePair(__m128i lo, __m128i hi) {
+	return _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi32(0xffff)), _mm_slli_epi32(hi, 16));
+}
+
+inline int32_t load32(const uint8_t* p) {
+	int32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+inline void store32(uint8_t* p, int32_t value) {
+	memcpy(p, &value, sizeof(value));
+}
+
+inline void store(float* p, __m128i v) {
+	_mm_storeu_ps(p, _mm_cvtepi32_ps(v));
+}
+
+inline void store(int32_t* p, __m128i v) {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+/// Stores lanes 0 and 2
+inline void storeEven(float* p, __m128i v) {
+	_mm_storel_pi(reinterpret_cast<__m64*>(p), _mm_cvtepi32_ps(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0))));
+}
+
+inline void storeEven(int32_t* p, __m128i v) {
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+inline __m128 load(const float* p) {
+	return _mm_loadu_ps(p);
+}
+
+inline __m128 load(const int32_t* p) {
+	return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+/// Loads samples 0, 0, 1, 1
+inline __m128 loadDoubled(const float* p) {
+	auto v = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+	return _mm_unpacklo_ps(v, v);
+}
+
+inline __m128 loadDoubled(const int32_t* p) {
+	auto v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi32(v, v));
+}
+
+/// Scales and rounds values to 8bits same way as toByte in colorplanes.cpp.
+inline __m128i toByte(__m128 values, __m128 scale) {
+	auto scaled = _mm_mul_ps(values, scale);
+	return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), _mm_set1_ps(255.0f)));
+}
+
+template <typename T>
+int splitYCbCr(const uint8_t* bgr, int cols, bool subsampled, T* luma, T* cr, T* cb) {
+	const auto byteMask = _mm_set1_epi32(0xff);
+	const auto lumaBG = coefPair(B2Y, G2Y);
+	const auto lumaR = coefPair(R2Y, 1 << (COLOR_SHIFT - 1));
+	const auto crCoef = coefPair(YCRI, 1 << (COLOR_SHIFT - 1));
+	const auto cbCoef = coefPair(YCBI, 1 << (COLOR_SHIFT - 1));
+	const auto one = _mm_set1_epi32(1);
+	const auto delta = _mm_set1_epi32(CHROMA_DELTA);
+
+	int x = 0;
+	for (; x + 4 < cols; x += 4, bgr += 12) {
+		auto pixels = _mm_setr_epi32(load32(bgr), load32(bgr + 3), load32(bgr + 6), load32(bgr + 9));
+		auto b = _mm_and_si128(pixels, byteMask);
+		auto g = _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask);
+		auto r = _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask);
+
+		auto y = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(valuePair(b, g), lumaBG),
+			_mm_madd_epi16(valuePair(r, one), lumaR)), COLOR_SHIFT);
+		auto crValue = _mm_srai_epi32(_mm_madd_epi16(valuePair(_mm_sub_epi32(r, y), one), crCoef), COLOR_SHIFT);
+		auto cbValue = _mm_srai_epi32(_mm_madd_epi16(valuePair(_mm_sub_epi32(b, y), one), cbCoef), COLOR_SHIFT);
+
+		// saturate both chroma to 0..255 in 16bit lanes
+		auto chroma = _mm_packs_epi32(_mm_add_epi32(crValue, delta), _mm_add_epi32(cbValue, delta));
+		chroma = _mm_min_epi16(_mm_max_epi16(chroma, _mm_setzero_si128()), _mm_set1_epi16(255));
+		crValue = _mm_unpacklo_epi16(chroma, _mm_setzero_si128());
+		cbValue = _mm_unpackhi_epi16(chroma, _mm_setzero_si128());
+
+		store(luma + x, y);
+		if (subsampled) {
+			storeEven(cr + x / 2, crValue);
+			storeEven(cb + x / 2, cbValue);
+		} else {
+			store(cr + x, crValue);
+			store(cb + x, cbValue);
+		}
+	}
+	return x;
+}
+
+template <typename T>
+int mergeYCbCr(const T* luma, const T* cr, const T* cb, int cols, int chromaCols, bool subsampled, float scale,
+	uint8_t* bgr) {
+	const auto scaleVec = _mm_set1_ps(scale);
+	const auto delta = _mm_set1_epi32(CHROMA_DELTA);
+	const auto one = _mm_set1_epi32(1);
+	const auto half = _mm_set1_epi32(1 << (COLOR_SHIFT - 1));
+	const auto blueCoef = coefPair(CB2BI, 1 << (COLOR_SHIFT - 1));
+	const auto greenCoef = coefPair(CB2GI, CR2GI);
+	const auto redCoef = coefPair(CR2RI, 1 << (COLOR_SHIFT - 1));
+
+	int x = 0;
+	for (; x + 4 < cols && (subsampled ? x / 2 + 2 : x + 4) <= chromaCols; x += 4, bgr += 12) {
+		auto y = toByte(load(luma + x), scaleVec);
+		__m128i crDiff, cbDiff;
+		if (subsampled) {
+			crDiff = _mm_sub_epi32(toByte(loadDoubled(cr + x / 2), scaleVec), delta);
+			cbDiff = _mm_sub_epi32(toByte(loadDoubled(cb + x / 2), scaleVec), delta);
+		} else {
+			crDiff = _mm_sub_epi32(toByte(load(cr + x), scaleVec), delta);
+			cbDiff = _mm_sub_epi32(toByte(load(cb + x), scaleVec), delta);
+		}
+
+		auto b = _mm_add_epi32(y, _mm_srai_epi32(_mm_madd_epi16(valuePair(cbDiff, one), blueCoef), COLOR_SHIFT));
+		auto g = _mm_add_epi32(y, _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(valuePair(cbDiff, crDiff), greenCoef), half),
+			COLOR_SHIFT));
+		auto r = _mm_add_epi32(y, _mm_srai_epi32(_mm_madd_epi16(valuePair(crDiff, one), redCoef), COLOR_SHIFT));
+
+		// saturated bytes b0..b3 g0..g3 r0..r3, then interleaved to one pixel per 32bit lane
+		auto bytes = _mm_packus_epi16(_mm_packs_epi32(b, g), _mm_packs_epi32(r, _mm_setzero_si128()));
+		auto bg = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 4));
+		auto r0 = _mm_unpacklo_epi8(_mm_srli_si128(bytes, 8), _mm_setzero_si128());
+		auto pixels = _mm_unpacklo_epi16(bg, r0);
+
+		store32(bgr, _mm_cvtsi128_si32(pixels));
+		store32(bgr + 3, _mm_cvtsi128_si32(_mm_srli_si128(pixels, 4)));
+		store32(bgr + 6, _mm_cvtsi128_si32(_mm_srli_si128(pixels, 8)));
+		store32(bgr + 9, _mm_cvtsi128_si32(_mm_srli_si128(pixels, 12)));
+	}
+	return x;
+}
+
+} // namespace
+
+int splitYCbCrSse2(const uint8_t* bgr, int cols, bool subsampled, float* luma, float* cr, float* cb) {
+	return splitYCbCr(bgr, cols, subsampled, luma, cr, cb);
+}
+
+int splitYCbCrSse2(const uint8_t* bgr, int cols, bool subsampled, int32_t* luma, int32_t* cr, int32_t* cb) {
+	return splitYCbCr(bgr, cols, subsampled, luma, cr, cb);
+}
+
+int mergeYCbCrSse2(const float* luma, const float* cr, const float* cb, int cols, int chromaCols, bool subsampled,
+	float scale, uint8_t* bgr) {
+	return mergeYCbCr(luma, cr, cb, cols, chromaCols, subsampled, scale, bgr);
+}
+
+int mergeYCbCrSse2(const int32_t* luma, const int32_t* cr, const int32_t* cb, int cols, int chromaCols, bool subsampled,
+	float scale, uint8_t* bgr) {
+	return mergeYCbCr(luma, cr, cb, cols, chromaCols, subsampled, scale, bgr);
+}
+
+#endif // WAVELET_SIMD_X86
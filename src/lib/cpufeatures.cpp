@@ -0,0 +1,96 @@
+/**
+ * @file cpufeatures.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "cpufeatures.h"
+
+#ifdef WAVELET_SIMD_X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#ifdef WAVELET_SIMD_X86
+
+/// Executes cpuid instruction with given leaf and subleaf, regs are eax, ebx, ecx, edx
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (int i = 0; i < 4; ++i)
+		regs[i] = static_cast<uint32_t>(info[i]);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/// Reads extended control register 0, which tells what register state os saves
+static uint64_t xgetbv0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static SimdLevel detect() {
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	uint32_t maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return SimdLevel::None;
+
+	cpuid(1, 0, regs);
+	bool sse2 = (regs[3] & (1U << 26)) != 0;
+	bool sse41 = (regs[2] & (1U << 19)) != 0;
+	bool osxsave = (regs[2] & (1U << 27)) != 0;
+	bool avx = (regs[2] & (1U << 28)) != 0;
+
+	if (!sse2)
+		return SimdLevel::None;
+	if (!sse41)
+		return SimdLevel::Sse2;
+
+	// avx registers are usable only when os saves ymm state (xcr0 bits 1 and 2)
+	if (maxLeaf >= 7 && osxsave && avx && (xgetbv0() & 0x6) == 0x6) {
+		cpuid(7, 0, regs);
+		if (regs[1] & (1U << 5))
+			return SimdLevel::Avx2;
+	}
+
+	return SimdLevel::Sse41;
+}
+
+#endif // WAVELET_SIMD_X86
+
+SimdLevel detectSimdLevel() {
+#ifdef WAVELET_SIMD_X86
+	static const SimdLevel level = detect();
+	return level;
+#else
+	return SimdLevel::None;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level) {
+	switch (level)
+	{
+	case SimdLevel::None:
+		return "scalar";
+	case SimdLevel::Sse2:
+		return "sse2";
+	case SimdLevel::Sse41:
+		return "sse4.1";
+	case SimdLevel::Avx2:
+		return "avx2";
+	default:
+		return "unknown";
+	}
+}
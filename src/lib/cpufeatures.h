@@ -0,0 +1,39 @@
+/**
+ * @file cpufeatures.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <cstdint>
+
+/**
+ * Vector instruction sets that wavelet kernels can use.
+ * Levels are ordered so higher level implies all lower ones.
+ */
+enum class SimdLevel : uint8_t { None, Sse2, Sse41, Avx2 };
+
+/**
+ * Detects best instruction set supported by both running cpu and this build.
+ * Detection is done only once, subsequent calls return cached value.
+ * @return SimdLevel::None when library was built without simd kernels
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * Clamps requested level to level supported by running cpu.
+ * @param requested level that caller wants to use
+ * @return min(requested, detectSimdLevel())
+ */
+inline SimdLevel clampSimdLevel(SimdLevel requested) {
+	auto detected = detectSimdLevel();
+	return requested < detected ? requested : detected;
+}
+
+/// Get human readable name of simd level.
+const char* simdLevelName(SimdLevel level);
+
+#endif // !CPU_FEATURES_H
@@ -9,6 +9,7 @@
 #define EZW_H
 
 #include <cstdlib>
+#include <cstdint>
 
 /**
  * Convenient base class of EzwDecoder and EzwEncoder.
@@ -17,18 +18,22 @@
 class EzwCodec
 {
 protected:
-	struct Element
-	{
-		enum class Code { Pos, Neg, IsolatedZero, ZeroTreeRoot };
+	/// Symbols of dominant pass
+	enum class Code { Pos, Neg, IsolatedZero, ZeroTreeRoot };
 
-		Element() {}
-		Element(size_t x, size_t y) : x(x), y(y) { }
+	EzwCodec() : treeCols(0), treeRows(0) {}
 
-		size_t x, y;
-		Code code;
-	};
+	/// Sets size of coded matrix, only coefs in its upper left quarter have children.
+	void setSize(size_t cols, size_t rows) {
+		treeCols = cols / 2;
+		treeRows = rows / 2;
+	}
 
-	EzwCodec() {}
+	bool hasChildren(size_t x, size_t y) const {
+		return x < treeCols && y < treeRows;
+	}
+
+	size_t treeCols, treeRows;		/// size of upper left quarter
 };
 
 #endif // !EZW_H
@@ -7,17 +7,45 @@
 
 #include "ezwdecoder.h"
 
+#include <stdexcept>
+#include <algorithm>
+
 //#define DUMP_RES
 
-void EzwDecoder::decode(int32_t threshold, int32_t minThreshold, cv::Mat& mat) {
+void EzwDecoder::decode(int32_t threshold, int32_t minThreshold, cv::Mat& mat, CoefLayout layout) {
 	if (mat.type() != CV_32S)
 		throw std::runtime_error("EzwDecoder::decode can operate only on 32b integer matrices");
 
+	setSize(mat.cols, mat.rows);
+	if (layout == CoefLayout::Morton) {
+		MortonLayout morton(mat.cols, mat.rows);
+		toLayout(mat, morton, reordered);
+		coefs = reordered.data();
+		decodeCoefs(morton, threshold, minThreshold);
+		fromLayout(reordered, morton, mat);
+	} else {
+		// coefs are addressed by linear index
+		cv::Mat m = mat.isContinuous() ? mat : mat.clone();
+		coefs = m.ptr<int32_t>();
+		decodeCoefs(RowMajorLayout(m.cols, m.rows), threshold, minThreshold);
+		if (m.data != mat.data)
+			m.copyTo(mat);
+	}
+}
+
+template <class Layout>
+void EzwDecoder::decodeCoefs(const Layout& layout, int32_t threshold, int32_t minThreshold) {
+	// every coef with children gets to queue at most once per pass
+	dpQueue.clear();
+	dpQueue.reserve(treeCols * treeRows);
+	subordVec.clear();
+	subordVec.reserve(layout.cols * layout.rows);
+
 	do {
 		dataModel.reset();
-		dominantPass(threshold, mat);
+		dominantPass(layout, threshold);
 
-		subordinatePass(threshold, minThreshold, mat);
+		subordinatePass(threshold, minThreshold);
 
 		threshold >>= 1;
 	} while(threshold > minThreshold);
@@ -27,105 +55,88 @@ void EzwDecoder::decode(int32_t threshold, int32_t minThreshold, cv::Mat& mat) {
 #endif
 }
 
-void EzwDecoder::dominantPass(int32_t threshold, cv::Mat& mat) {
-	initDominantPassQueue(threshold, mat);
-
-	do {
-		auto elm = dpQueue.front();
-		dpQueue.pop_front();
-		if (elm.code == Element::Code::Neg || elm.code == Element::Code::Pos)
-			pixels++;
-
-		if (elm.code != Element::Code::ZeroTreeRoot) {
-			// handle elm children
-			auto minx = elm.x * 2;
-			auto miny = elm.y * 2;
-			auto maxx = minx + 1;
-			auto maxy = miny + 1;
-			if (maxx <= (size_t)mat.cols && maxy <= (size_t)mat.rows) {						// last level doesn't have children
-				for (auto y = miny; y < maxy + 1; ++y) {
-					for (auto x = minx; x < maxx + 1; ++x) {
-						auto child = decodeElement(threshold, x, y, mat);
-						dpQueue.push_back(child);
-					}
-				}
-			}
+template <class Layout>
+void EzwDecoder::dominantPass(const Layout& layout, int32_t threshold) {
+	// mirrors EzwEncoder::dominantPass
+	dpQueue.clear();
+	decodeElement(layout, threshold, 0, 0);
+
+	decodeElement(layout, threshold, 1, 0);
+	decodeElement(layout, threshold, 0, 1);
+	decodeElement(layout, threshold, 1, 1);
+
+	for (size_t head = 0; head < dpQueue.size(); ++head) {
+		size_t x = layout.x(dpQueue[head]);
+		size_t y = layout.y(dpQueue[head]);
+		for (auto cy = y * 2; cy < y * 2 + 2; ++cy) {
+			for (auto cx = x * 2; cx < x * 2 + 2; ++cx)
+				decodeElement(layout, threshold, cx, cy);
 		}
-
-	} while (!dpQueue.empty());
+	}
 }
 
-void EzwDecoder::subordinatePass(int32_t threshold, int32_t minThreshold, cv::Mat& mat) {
+void EzwDecoder::subordinatePass(int32_t threshold, int32_t minThreshold) {
 	threshold >>= 1;
 	if (threshold <= minThreshold)
 		return;
 
-	for (size_t i = 0; i < pixels; ++i) {
-		auto coord = subordVec[i];
-		auto elm = mat.at<int32_t>(coord.y, coord.x);
-		if (bitStreamReader->readBit()) {
+	// bits are read by fields of 32, last field is shorter
+	for (size_t begin = 0; begin < subordVec.size(); begin += 32) {
+		auto fieldBits = static_cast<unsigned>(std::min<size_t>(32, subordVec.size() - begin));
+		uint32_t field = bitStreamReader->readBits(fieldBits);
+
+		for (unsigned b = 0; b < fieldBits; ++b) {
+			auto i = subordVec[begin + b];
+			auto elm = coefs[i];
+			if ((field >> (fieldBits - 1 - b)) & 1) {
 #ifdef DUMP_RES
-			std::cerr << "1";
+				std::cerr << "1";
 #endif
-			if (elm < 0)
-				mat.at<int32_t>(coord.y, coord.x) = elm - threshold;
-			else
-				mat.at<int32_t>(coord.y, coord.x) = elm + threshold;
-		} 
+				if (elm < 0)
+					coefs[i] = elm - threshold;
+				else
+					coefs[i] = elm + threshold;
+			}
 #ifdef DUMP_RES
-		else
-			std::cerr << "0";
+			else
+				std::cerr << "0";
 #endif
+		}
 	}
 }
 
-void EzwDecoder::initDominantPassQueue(int32_t threshold, cv::Mat& m) {
-	Element elm;
-
-	elm = decodeElement(threshold, 0, 0, m);
-	if (elm.code == Element::Code::Neg || elm.code == Element::Code::Pos)
-		pixels++;
-
-	elm = decodeElement(threshold, 1, 0, m);
-	dpQueue.push_back(elm);
-
-	elm = decodeElement(threshold, 0, 1, m);
-	dpQueue.push_back(elm);
-
-	elm = decodeElement(threshold, 1, 1, m);
-	dpQueue.push_back(elm);
-}
-
-EzwCodec::Element EzwDecoder::decodeElement(int32_t threshold, size_t x, size_t y, cv::Mat& m) {
-	Element result(x, y);
-	result.code = readElementCode();
-
-	if (result.code == Element::Code::Pos) {
-		m.at<int32_t>(y, x) = threshold;
-		subordVec.push_back(ElementCoord(x, y));
-	} else if (result.code == Element::Code::Neg) {
-		m.at<int32_t>(y, x) = -threshold;
-		subordVec.push_back(ElementCoord(x, y));
+template <class Layout>
+void EzwDecoder::decodeElement(const Layout& layout, int32_t threshold, size_t x, size_t y) {
+	auto code = readElementCode();
+	auto index = layout.index(x, y);
+
+	if (code == Code::Pos) {
+		coefs[index] = threshold;
+		subordVec.push_back(index);
+	} else if (code == Code::Neg) {
+		coefs[index] = -threshold;
+		subordVec.push_back(index);
 	}
 
-	return result;
+	if (code != Code::ZeroTreeRoot && hasChildren(x, y) && (x != 0 || y != 0))
+		dpQueue.push_back(index);
 }
 
-EzwCodec::Element::Code EzwDecoder::readElementCode() {
-	auto code = static_cast<Element::Code>(adecoder->decode(&dataModel));
+EzwCodec::Code EzwDecoder::readElementCode() {
+	auto code = static_cast<Code>(rdecoder ? rdecoder->decode(dataModel) : adecoder->decode(dataModel));
 #ifdef DUMP_RES
 	switch (code)
 	{
-	case EzwCodec::Element::Code::Pos:
+	case Code::Pos:
 		std::cerr << "p";
 		break;
-	case EzwCodec::Element::Code::Neg:
+	case Code::Neg:
 		std::cerr << "n";
 		break;
-	case EzwCodec::Element::Code::IsolatedZero:
+	case Code::IsolatedZero:
 		std::cerr << "z";
 		break;
-	case EzwCodec::Element::Code::ZeroTreeRoot:
+	case Code::ZeroTreeRoot:
 		std::cerr << "t";
 		break;
 	default:
@@ -138,24 +149,24 @@ EzwCodec::Element::Code EzwDecoder::readElementCode() {
 #ifdef DUMP_RES
 			std::cerr << "t";
 #endif
-			return EzwCodec::Element::Code::ZeroTreeRoot;
+			return Code::ZeroTreeRoot;
 		} else {
 #ifdef DUMP_RES
 			std::cerr << "z";
 #endif
-			return EzwCodec::Element::Code::IsolatedZero;
+			return Code::IsolatedZero;
 		}
 	} else {
 		if (adecoder->reader()->readBit()) {
 #ifdef DUMP_RES
 			std::cerr << "n";
 #endif
-			return EzwCodec::Element::Code::Neg;
+			return Code::Neg;
 		} else {
 #ifdef DUMP_RES
 			std::cerr << "p";
 #endif
-			return EzwCodec::Element::Code::Pos;
+			return Code::Pos;
 		}
 	}*/
 }
\ No newline at end of file
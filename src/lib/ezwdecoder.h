@@ -11,11 +11,12 @@
 #include "ezw.h"
 #include "bitstream.h"
 #include "arithmdecoder.h"
+#include "rangedecoder.h"
+#include "coeflayout.h"
 
 #include <opencv2/core/core.hpp>
 
 #include <memory>
-#include <deque>
 #include <vector>
 
 /**
@@ -30,39 +31,53 @@ public:
 	 * @param adecoder dominant pass will be decoded by this arithmetic decoder
 	 * @param bsr stream where subordinate pass is
 	 */
-	EzwDecoder(std::shared_ptr<ArithmeticDecoder>& adecoder, std::shared_ptr<BitStreamReader>& bsr) 
-		: dataModel(4), adecoder(adecoder), bitStreamReader(bsr), pixels(0) { }
+	EzwDecoder(const std::shared_ptr<ArithmeticDecoder>& adecoder, const std::shared_ptr<BitStreamReader>& bsr) 
+		: dataModel(4), adecoder(adecoder), bitStreamReader(bsr), coefs(nullptr) { }
+
+	/**
+	 * Constructs new decoder for dominant pass coded by range coder.
+	 * @param rdecoder dominant pass will be decoded by this range decoder
+	 * @param bsr stream where subordinate pass is
+	 */
+	EzwDecoder(const std::shared_ptr<RangeDecoder>& rdecoder, const std::shared_ptr<BitStreamReader>& bsr) 
+		: dataModel(4, RangeCoderTraits::MAX_TOTAL), rdecoder(rdecoder), bitStreamReader(bsr), coefs(nullptr) { }
 
 	/**
 	 * Decodes matrix from streams.
 	 * @param threshold threshold value used while encoding
 	 * @param minThreshold minimum threshold value used while encoding
+	 * @param layout order in which coefs are kept while decoding, it
+	 *     doesn't have to match layout used by encoder
 	 * @retval decoded matrix
 	 */
-	void decode(int32_t threshold, int32_t minThreshold, cv::Mat& mat);
+	void decode(int32_t threshold, int32_t minThreshold, cv::Mat& mat, CoefLayout layout = CoefLayout::RowMajor);
 private:
-	void dominantPass(int32_t threshold, cv::Mat& mat);
-	void subordinatePass(int32_t threshold, int32_t minThreshold, cv::Mat& mat);
+	template <class Layout>
+	void decodeCoefs(const Layout& layout, int32_t threshold, int32_t minThreshold);
+
+	template <class Layout>
+	void dominantPass(const Layout& layout, int32_t threshold);
+
+	void subordinatePass(int32_t threshold, int32_t minThreshold);
+
+	/// Decodes coef and puts it to queue when its children are coded too.
+	template <class Layout>
+	void decodeElement(const Layout& layout, int32_t threshold, size_t x, size_t y);
 
-	void initDominantPassQueue(int32_t threshold, cv::Mat& m);
-	Element decodeElement(int32_t threshold, size_t x, size_t y, cv::Mat& m);
-	Element::Code readElementCode();
+	Code readElementCode();
 
 	AdaptiveDataModel dataModel;
 	std::shared_ptr<ArithmeticDecoder> adecoder;
+	std::shared_ptr<RangeDecoder> rdecoder;		/// used instead of adecoder when set
 
 	std::shared_ptr<BitStreamReader> bitStreamReader;
 
-	std::deque<Element> dpQueue;
+	int32_t* coefs;					/// coefs of decoded matrix
 
-	struct ElementCoord
-	{
-		ElementCoord() { }
-		ElementCoord(size_t x, size_t y) : x(x), y(y) { }
-		size_t x, y;
-	};
-	std::vector<ElementCoord> subordVec;
-	size_t pixels;
+	// following arrays are reserved once per matrix and reused by all passes
+	std::vector<uint32_t> dpQueue;		/// indices of coefs whose children are decoded later
+	std::vector<uint32_t> subordVec;	/// indices of significant coefs
+	std::vector<int32_t> reordered;		/// coefs in layout other than row major
 };
 
 #endif // !EZW_DECODER_H
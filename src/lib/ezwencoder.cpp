@@ -10,16 +10,40 @@
 #include <stdexcept>
 #include <cstdint>
 #include <cmath>
+#include <algorithm>
 
 //#define DUMP_RES
 
-void EzwEncoder::encode(cv::Mat& mat, int32_t threshold, int32_t minThreshold) {
+void EzwEncoder::encode(cv::Mat& mat, int32_t threshold, int32_t minThreshold, CoefLayout layout) {
 	if (mat.type() != CV_32S)
 		throw std::runtime_error("EzwEncoder::encode can operate only on 32b integer matrices");
 
+	setSize(mat.cols, mat.rows);
+	if (layout == CoefLayout::Morton) {
+		MortonLayout morton(mat.cols, mat.rows);
+		toLayout(mat, morton, reordered);
+		coefs = reordered.data();
+		encodeCoefs(morton, threshold, minThreshold);
+	} else {
+		// coefs are addressed by linear index
+		cv::Mat m = mat.isContinuous() ? mat : mat.clone();
+		coefs = m.ptr<int32_t>();
+		encodeCoefs(RowMajorLayout(m.cols, m.rows), threshold, minThreshold);
+	}
+}
+
+template <class Layout>
+void EzwEncoder::encodeCoefs(const Layout& layout, int32_t threshold, int32_t minThreshold) {
+	// every coef with children gets to queue at most once per pass
+	dpQueue.clear();
+	dpQueue.reserve(treeCols * treeRows);
+	subordList.clear();
+	subordList.reserve(layout.cols * layout.rows);
+
+	buildDescendantMax(layout);
 	do {
 		dataModel.reset();
-		dominantPass(mat, threshold);
+		dominantPass(layout, threshold);
 
 		subordinatePass(threshold, minThreshold);
 
@@ -30,7 +54,10 @@ void EzwEncoder::encode(cv::Mat& mat, int32_t threshold, int32_t minThreshold) {
 	std::cerr << std::endl;
 #endif
 
-	aencoder->close();
+	if (rencoder)
+		rencoder->close();
+	else
+		aencoder->close();
 	bitStreamWriter->flush();
 }
 
@@ -43,33 +70,26 @@ int32_t EzwEncoder::computeInitTreshold(const cv::Mat& m) {
 	return 1 << static_cast<int32_t>(floor(log10(absmax) / log10(2.0)));
 }
 
-void EzwEncoder::dominantPass(cv::Mat& mat, int32_t threshold) {
-	initDominantPassQueue(mat, threshold);
-
-	do {
-		// get elm from queue and output it
-		auto elm = dpQueue.front();
-		dpQueue.pop_front();
-		outputCode(elm.code);
-
-		// we don't need to code zerotree children cos they are zero
-		if (elm.code != Element::Code::ZeroTreeRoot) {
-			// handle elm children
-			auto minx = elm.x * 2;
-			auto miny = elm.y * 2;
-			auto maxx = minx + 1;
-			auto maxy = miny + 1;
-			if (maxx <= (size_t)mat.cols && maxy <= (size_t)mat.rows) {						// last level doesn't have children
-				for (auto y = miny; y < maxy + 1; ++y) {
-					for (auto x = minx; x < maxx + 1; ++x) {
-						auto child = codeElement(mat, x, y, threshold);
-						dpQueue.push_back(child);
-					}
-				}
-			}
+template <class Layout>
+void EzwEncoder::dominantPass(const Layout& layout, int32_t threshold) {
+	// coefs are coded when they're put to queue instead of when they're
+	// taken from it, queue is fifo so order of codes is same
+	dpQueue.clear();
+	codeElement(layout, 0, 0, threshold);
+
+	// children of first coef are always visited
+	codeElement(layout, 1, 0, threshold);
+	codeElement(layout, 0, 1, threshold);
+	codeElement(layout, 1, 1, threshold);
+
+	for (size_t head = 0; head < dpQueue.size(); ++head) {
+		size_t x = layout.x(dpQueue[head]);
+		size_t y = layout.y(dpQueue[head]);
+		for (auto cy = y * 2; cy < y * 2 + 2; ++cy) {
+			for (auto cx = x * 2; cx < x * 2 + 2; ++cx)
+				codeElement(layout, cx, cy, threshold);
 		}
-
-	} while(!dpQueue.empty());
+	}
 }
 
 void EzwEncoder::subordinatePass(int32_t threshold, int32_t minThreshold) {
@@ -77,121 +97,132 @@ void EzwEncoder::subordinatePass(int32_t threshold, int32_t minThreshold) {
 	if (threshold <= minThreshold)
 		return;
 
+	// bits are gathered to fields, so writer is called once per 32 coefs
+	uint32_t field = 0;
+	unsigned fieldBits = 0;
 	for (auto elm : subordList) {
 		// threshold is some power of two so it has single bit set
 		// and since we are lowering thresholds from max value we
 		// can determine if elm is higher than threshold just by simple
 		// test if elm has same bit set like threshold
-		if ((elm & threshold) != 0) {
-#ifdef DUMP_RES
-			std::cerr << "1";
-#endif
-			bitStreamWriter->writeBit(true);
-		} else {
+		bool bit = (elm & threshold) != 0;
 #ifdef DUMP_RES
-			std::cerr << "0";
+		std::cerr << (bit ? "1" : "0");
 #endif
-			bitStreamWriter->writeBit(false);
+		field = (field << 1) | (bit ? 1U : 0U);
+		if (++fieldBits == 32) {
+			bitStreamWriter->writeBits(field, 32);
+			field = 0;
+			fieldBits = 0;
 		}
 	}
+	bitStreamWriter->writeBits(field, fieldBits);
 }
 
-void EzwEncoder::initDominantPassQueue(cv::Mat& m, int32_t threshold) {
-	Element elm;
-
-	elm = codeElement(m, 0, 0, threshold);
-	outputCode(elm.code);
-
-	elm = codeElement(m, 1, 0, threshold);
-	dpQueue.push_back(elm);
-
-	elm = codeElement(m, 0, 1, threshold);
-	dpQueue.push_back(elm);
+template <class Layout>
+void EzwEncoder::codeElement(const Layout& layout, size_t x, size_t y, int32_t threshold) {
+	auto code = computeElementCode(layout, x, y, threshold);
+	outputCode(code);
 
-	elm = codeElement(m, 1, 1, threshold);
-	dpQueue.push_back(elm);
-}
-
-EzwCodec::Element EzwEncoder::codeElement(cv::Mat& m, size_t x, size_t y, int32_t threshold) {
-	Element result(x, y);
-	result.code = computeElementCode(m, x, y, threshold);
-	if (result.code == Element::Code::Pos || result.code == Element::Code::Neg) {
-		subordList.push_back(abs(m.at<int32_t>(y, x)));
-		m.at<int32_t>(y, x) = 0;
+	if (code == Code::Pos || code == Code::Neg) {
+		int32_t& coef = coefs[layout.index(x, y)];
+		subordList.push_back(abs(coef));
+		coef = 0;
+		updateDescendantMax(layout, x, y);
 	}
 
-	return result;
+	// we don't need to code zerotree children cos they are zero
+	if (code != Code::ZeroTreeRoot && hasChildren(x, y) && (x != 0 || y != 0))
+		dpQueue.push_back(layout.index(x, y));
 }
 
-EzwCodec::Element::Code EzwEncoder::computeElementCode(cv::Mat& m, size_t x, size_t y, int32_t threshold) {
-	auto coef = m.at<int32_t>(y, x);
+template <class Layout>
+EzwCodec::Code EzwEncoder::computeElementCode(const Layout& layout, size_t x, size_t y, int32_t threshold) {
+	auto coef = coefs[layout.index(x, y)];
 	if (abs(coef) >= threshold) {
 		if (coef >= 0)
-			return Element::Code::Pos;
+			return Code::Pos;
 		else
-			return Element::Code::Neg;
+			return Code::Neg;
 	} else {
-		if (isZerotreeRoot(m, x, y, threshold))
-			return Element::Code::ZeroTreeRoot;
+		if (isZerotreeRoot(layout, x, y, threshold))
+			return Code::ZeroTreeRoot;
 		else
-			return Element::Code::IsolatedZero;
+			return Code::IsolatedZero;
 	}
 }
 
-bool EzwEncoder::isZerotreeRoot(cv::Mat& m, size_t x, size_t y, int32_t threshold) {
-	// handle first coef
-	if (x == 0 && y == 0) {
-		// find max value in rest of m
-		auto tmp = m.at<int32_t>(y, x);
-		m.at<int32_t>(y, x) = std::numeric_limits<int32_t>::min();
-		double absmax;
-		cv::minMaxIdx(cv::abs(m), nullptr, &absmax);
-		m.at<int32_t>(y, x) = tmp;
-
-		// if [0,0] is not highest value then its not zerotree root
-		if (absmax >= threshold)
-			return false;
+template <class Layout>
+bool EzwEncoder::isZerotreeRoot(const Layout& layout, size_t x, size_t y, int32_t threshold) {
+	// children of first coef are always visited, so its code doesn't matter
+	// and it's always coded as isolated zero
+	if (x == 0 && y == 0)
+		return false;
+
+	// coefs of last level don't have children
+	if (!hasChildren(x, y))
 		return true;
+
+	return descendantMax[layout.treeIndex(x, y)] < threshold;
+}
+
+template <class Layout>
+void EzwEncoder::buildDescendantMax(const Layout& layout) {
+	descendantMax.assign(layout.treeSize(), 0);
+
+	// children of x, y are at 2x, 2y so they are always visited before their parent
+	for (size_t y = treeRows; y-- > 0;) {
+		for (size_t x = treeCols; x-- > 0;)
+			descendantMax[layout.treeIndex(x, y)] = childrenMax(layout, x, y);
 	}
+}
 
-	auto minx = x * 2;
-	auto miny = y * 2;
-	auto maxx = (x + 1) * 2;
-	auto maxy = (y + 1) * 2;
-	if (minx == m.cols || miny == m.rows)
-		return true;
+template <class Layout>
+void EzwEncoder::updateDescendantMax(const Layout& layout, size_t x, size_t y) {
+	// coef x, y changed, so fix its ancestors until some of them isn't affected
+	while (x != 0 || y != 0) {
+		x /= 2;
+		y /= 2;
+		int32_t max = childrenMax(layout, x, y);
+		int32_t& stored = descendantMax[layout.treeIndex(x, y)];
+		if (max == stored)
+			break;
+		stored = max;
+	}
+}
 
-	while (maxx <= (size_t)m.cols && maxy <= (size_t)m.rows) {
-		for (auto i = miny; i < maxy; ++i) {
-			for (auto j = minx; j < maxx; ++j) {
-				if (abs(m.at<int32_t>(i, j)) >= threshold)
-					return false;
-			}
+template <class Layout>
+int32_t EzwEncoder::childrenMax(const Layout& layout, size_t x, size_t y) const {
+	int32_t result = 0;
+	for (size_t cy = y * 2; cy < y * 2 + 2; ++cy) {
+		for (size_t cx = x * 2; cx < x * 2 + 2; ++cx) {
+			// first coef isn't descendant of itself
+			if (cx == 0 && cy == 0)
+				continue;
+
+			result = std::max(result, abs(coefs[layout.index(cx, cy)]));
+			if (hasChildren(cx, cy))
+				result = std::max(result, descendantMax[layout.treeIndex(cx, cy)]);
 		}
-
-		minx *= 2;
-		miny *= 2;
-		maxx *= 2;
-		maxy *= 2;
 	}
 
-	return true;
+	return result;
 }
 
-void EzwEncoder::outputCode(Element::Code code) {
+void EzwEncoder::outputCode(Code code) {
 #ifdef DUMP_RES
 	switch (code)
 	{
-	case EzwCodec::Element::Code::Pos:
+	case Code::Pos:
 		std::cerr << "p";
 		break;
-	case EzwCodec::Element::Code::Neg:
+	case Code::Neg:
 		std::cerr << "n";
 		break;
-	case EzwCodec::Element::Code::IsolatedZero:
+	case Code::IsolatedZero:
 		std::cerr << "z";
 		break;
-	case EzwCodec::Element::Code::ZeroTreeRoot:
+	case Code::ZeroTreeRoot:
 
 		std::cerr << "t";
 		break;
@@ -199,5 +230,8 @@ void EzwEncoder::outputCode(Element::Code code) {
 		break;
 	}
 #endif
-	aencoder->encode(static_cast<unsigned>(code), &dataModel);
+	if (rencoder)
+		rencoder->encode(static_cast<unsigned>(code), dataModel);
+	else
+		aencoder->encode(static_cast<unsigned>(code), dataModel);
 }
\ No newline at end of file
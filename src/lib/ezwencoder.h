@@ -11,12 +11,13 @@
 #include "ezw.h"
 #include "bitstream.h"
 #include "arithmencoder.h"
+#include "rangeencoder.h"
+#include "coeflayout.h"
 
 #include <opencv2/core/core.hpp>
 
 #include <memory>
-#include <deque>
-#include <list>
+#include <vector>
 
 /**
  * Embedded zero tree wavelet transform encoder.
@@ -34,35 +35,75 @@ public:
 	 * @param aencoder arithmetic encoder used for dominant pass results
 	 * @param bsw stream for subordinate pass results
 	 */
-	EzwEncoder(std::shared_ptr<ArithmeticEncoder>& aencoder, std::shared_ptr<BitStreamWriter>& bsw) 
-		: dataModel(4), aencoder(aencoder), bitStreamWriter(bsw) { }
+	EzwEncoder(const std::shared_ptr<ArithmeticEncoder>& aencoder, const std::shared_ptr<BitStreamWriter>& bsw) 
+		: dataModel(4), aencoder(aencoder), bitStreamWriter(bsw), coefs(nullptr) { }
+
+	/**
+	 * Constructs new encoder that codes dominant pass by byte oriented range coder.
+	 * It's faster than arithmetic coder, model is rescaled more often, which
+	 * makes it adapt faster, but code is different.
+	 * @param rencoder range encoder used for dominant pass results
+	 * @param bsw stream for subordinate pass results
+	 */
+	EzwEncoder(const std::shared_ptr<RangeEncoder>& rencoder, const std::shared_ptr<BitStreamWriter>& bsw) 
+		: dataModel(4, RangeCoderTraits::MAX_TOTAL), rencoder(rencoder), bitStreamWriter(bsw), coefs(nullptr) { }
 
 	/**
 	 * Encodes matrix to streams.
-	 * @param mat input matrix to be encoded
+	 * @param mat input matrix to be encoded, encoding may overwrite it
 	 * @param threshold initial threshold should be from computeInitTreshold call and power of two
 	 * @param minThreshold threshold when encoding stops, should be power of two.
+	 * @param layout order in which coefs are kept while encoding, it doesn't
+	 *     change output, Morton layout makes tree traversal cache friendly
 	 */
-	void encode(cv::Mat& mat, int32_t threshold, int32_t minThreshold = 0);
+	void encode(cv::Mat& mat, int32_t threshold, int32_t minThreshold = 0, CoefLayout layout = CoefLayout::RowMajor);
 
 	/// Computes initial threshold for encoding matrix m.
 	static int32_t computeInitTreshold(const cv::Mat& m);
 private:
-	void dominantPass(cv::Mat& mat, int32_t threshold);
+	template <class Layout>
+	void encodeCoefs(const Layout& layout, int32_t threshold, int32_t minThreshold);
+
+	template <class Layout>
+	void dominantPass(const Layout& layout, int32_t threshold);
+
 	void subordinatePass(int32_t threshold, int32_t minThreshold);
 
-	void initDominantPassQueue(cv::Mat& m, int32_t threshold);
-	Element codeElement(cv::Mat& m, size_t x, size_t y, int32_t threshold);
-	Element::Code computeElementCode(cv::Mat& m, size_t x, size_t y, int32_t threshold);
-	bool isZerotreeRoot(cv::Mat& m, size_t x, size_t y, int32_t threshold);
-	void outputCode(Element::Code code);
+	/// Codes coef and puts it to queue when its children has to be coded too.
+	template <class Layout>
+	void codeElement(const Layout& layout, size_t x, size_t y, int32_t threshold);
+
+	template <class Layout>
+	Code computeElementCode(const Layout& layout, size_t x, size_t y, int32_t threshold);
+
+	template <class Layout>
+	bool isZerotreeRoot(const Layout& layout, size_t x, size_t y, int32_t threshold);
+
+	void outputCode(Code code);
+
+	template <class Layout>
+	void buildDescendantMax(const Layout& layout);
+
+	template <class Layout>
+	void updateDescendantMax(const Layout& layout, size_t x, size_t y);
+
+	template <class Layout>
+	int32_t childrenMax(const Layout& layout, size_t x, size_t y) const;
 
 	AdaptiveDataModel dataModel;
 	std::shared_ptr<ArithmeticEncoder> aencoder;
+	std::shared_ptr<RangeEncoder> rencoder;		/// used instead of aencoder when set
 	std::shared_ptr<BitStreamWriter> bitStreamWriter;
 
-	std::deque<Element> dpQueue;
-	std::list<int32_t> subordList;
+	int32_t* coefs;					/// coefs of encoded matrix
+
+	// following arrays are reserved once per matrix and reused by all passes
+	std::vector<uint32_t> dpQueue;		/// indices of coefs whose children are coded later
+	std::vector<int32_t> subordList;	/// magnitudes of significant coefs
+	std::vector<int32_t> reordered;		/// coefs in layout other than row major
+
+	/// max of absolute values of descendants for every coef that has children, by treeIndex
+	std::vector<int32_t> descendantMax;
 };
 
 #endif // !EZW_ENCODER_H
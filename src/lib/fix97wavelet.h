@@ -0,0 +1,71 @@
+/**
+ * @file fix97wavelet.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef FIX97_WAVELET_H
+#define FIX97_WAVELET_H
+
+#include "liftingwavelet.h"
+
+#include <cstdint>
+
+/// Cdf 9/7 lifting coeficients in Q14 fixed point format
+struct Fix97Coefs
+{
+	static const int FRACTION_BITS = 14;
+
+	static const int32_t ALPHA = -25987;		// -1.586134342060
+	static const int32_t BETA = -868;			// -0.052980118573
+	static const int32_t GAMMA = 14466;			// 0.882911075531
+	static const int32_t DELTA = 7266;			// 0.443506852044
+	static const int32_t ZETA = 18835;			// 1.149604398860
+	static const int32_t INV_ZETA = 14252;		// 1 / zeta
+
+	/// Get round(coef * value) for coef in Q14 format.
+	static int32_t mul(int32_t coef, int32_t value) {
+		// product doesn't fit to 32 bits for coefs of deeper levels
+		int64_t product = static_cast<int64_t>(coef) * value + (1 << (FRACTION_BITS - 1));
+		return static_cast<int32_t>(product >> FRACTION_BITS);
+	}
+};
+
+/// Lifting step target += round(Coef * (b + c))
+template <int32_t Coef>
+struct Fix97Step
+{
+	static int32_t delta(int32_t, int32_t b, int32_t c, int32_t) {
+		return Fix97Coefs::mul(Coef, b + c);
+	}
+};
+
+/// Scales approx coefs by zeta and detail coefs by 1 / zeta
+struct Fix97Scaling
+{
+	static int32_t approx(int32_t even) { return Fix97Coefs::mul(Fix97Coefs::ZETA, even); }
+	static int32_t detail(int32_t odd) { return Fix97Coefs::mul(Fix97Coefs::INV_ZETA, odd); }
+	static int32_t even(int32_t approx) { return Fix97Coefs::mul(Fix97Coefs::INV_ZETA, approx); }
+	static int32_t odd(int32_t detail) { return Fix97Coefs::mul(Fix97Coefs::ZETA, detail); }
+};
+
+/// Cdf 9/7 lifting scheme in fixed point
+struct Fix97Scheme : LiftingSteps<Fix97Step<Fix97Coefs::ALPHA>, Fix97Step<Fix97Coefs::BETA>,
+	Fix97Step<Fix97Coefs::GAMMA>, Fix97Step<Fix97Coefs::DELTA>>
+{
+	typedef int32_t value_type;
+	typedef Fix97Scaling Scaling;
+};
+
+/**
+ * Cdf 9/7 wavelet in fixed point arithmetic.
+ * Approximates Cdf97Wavelet on integers, so lossy coding doesn't need float
+ * conversions and gives same output on every platform. Lifting steps are
+ * reversible, only scaling rounds, so it isn't lossless.
+ */
+class Fix97Wavelet : public LiftingWavelet<Fix97Scheme>
+{
+};
+
+#endif // !FIX97_WAVELET_H
@@ -0,0 +1,47 @@
+/**
+ * @file haarwavelet.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef HAAR_WAVELET_H
+#define HAAR_WAVELET_H
+
+#include "liftingwavelet.h"
+
+#include <cstdint>
+
+/// Haar predict: odd -= even[i]
+struct HaarPredict
+{
+	static int32_t delta(int32_t, int32_t b, int32_t, int32_t) {
+		return -b;
+	}
+};
+
+/// Haar update: even += odd[i] / 2
+struct HaarUpdate
+{
+	static int32_t delta(int32_t, int32_t, int32_t c, int32_t) {
+		return c >> 1;
+	}
+};
+
+/// Integer Haar lifting scheme (S transform)
+struct HaarScheme : LiftingSteps<HaarPredict, HaarUpdate>
+{
+	typedef int32_t value_type;
+	typedef NoScaling Scaling;
+};
+
+/**
+ * Haar wavelet.
+ * Reversible integer implementation, approx coefs are floor of pair average
+ * and detail coefs are pair differences.
+ */
+class HaarWavelet : public LiftingWavelet<HaarScheme>
+{
+};
+
+#endif // !HAAR_WAVELET_H
@@ -0,0 +1,39 @@
+/**
+ * @file int137wavelet.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef INT137_WAVELET_H
+#define INT137_WAVELET_H
+
+#include "liftingwavelet.h"
+#include "int97wavelet.h"
+
+#include <cstdint>
+
+/// 4 tap update: even += (9 * (odd[i - 1] + odd[i]) - (odd[i - 2] + odd[i + 1]) + 16) / 32
+struct Int137Update
+{
+	static int32_t delta(int32_t a, int32_t b, int32_t c, int32_t d) {
+		return (9 * (b + c) - (a + d) + 16) >> 5;
+	}
+};
+
+/// Integer 13/7-T lifting scheme, predict is shared with 9/7-M
+struct Int137Scheme : LiftingSteps<Int97Predict, Int137Update>
+{
+	typedef int32_t value_type;
+	typedef NoScaling Scaling;
+};
+
+/**
+ * Integer 13/7-T wavelet.
+ * Reversible wavelet with 13 tap analysis lowpass and 7 tap highpass filter.
+ */
+class Int137Wavelet : public LiftingWavelet<Int137Scheme>
+{
+};
+
+#endif // !INT137_WAVELET_H
@@ -0,0 +1,47 @@
+/**
+ * @file int97wavelet.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef INT97_WAVELET_H
+#define INT97_WAVELET_H
+
+#include "liftingwavelet.h"
+
+#include <cstdint>
+
+/// 4 tap predict: odd -= (9 * (even[i] + even[i + 1]) - (even[i - 1] + even[i + 2]) + 8) / 16
+struct Int97Predict
+{
+	static int32_t delta(int32_t a, int32_t b, int32_t c, int32_t d) {
+		return -((9 * (b + c) - (a + d) + 8) >> 4);
+	}
+};
+
+/// 2 tap update: even += (odd[i - 1] + odd[i] + 2) / 4
+struct Int97Update
+{
+	static int32_t delta(int32_t, int32_t b, int32_t c, int32_t) {
+		return (b + c + 2) >> 2;
+	}
+};
+
+/// Integer 9/7-M lifting scheme
+struct Int97Scheme : LiftingSteps<Int97Predict, Int97Update>
+{
+	typedef int32_t value_type;
+	typedef NoScaling Scaling;
+};
+
+/**
+ * Integer 9/7-M wavelet.
+ * Reversible wavelet with 9 tap analysis lowpass and 7 tap highpass filter,
+ * it approximates cdf 9/7 in integer arithmetic.
+ */
+class Int97Wavelet : public LiftingWavelet<Int97Scheme>
+{
+};
+
+#endif // !INT97_WAVELET_H
@@ -0,0 +1,101 @@
+/**
+ * @file liftingavx2.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "liftingkernels.h"
+
+#ifdef WAVELET_SIMD_X86
+
+#include "liftingsimd.h"
+
+#include <immintrin.h>
+
+namespace {
+
+/// Vector traits for 8 floats in avx register
+struct Avx2Float
+{
+	typedef __m256 type;
+	static const size_t WIDTH = 8;
+
+	static type load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+	static type set1(float v) { return _mm256_set1_ps(v); }
+	static type add(type a, type b) { return _mm256_add_ps(a, b); }
+	static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+	static type div(type a, type b) { return _mm256_div_ps(a, b); }
+
+	static void deinterleave(const float* p, type& even, type& odd) {
+		auto lo = _mm256_loadu_ps(p);
+		auto hi = _mm256_loadu_ps(p + WIDTH);
+		// shuffle works in 128b lanes, so result is 0 2 8 10 4 6 12 14 and
+		// 64b pairs must be reordered afterwards
+		auto e = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		auto o = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+		even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0)));
+		odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	static void interleave(float* p, type even, type odd) {
+		// unpack works in 128b lanes, so lo is e0 o0 e1 o1 e4 o4 e5 o5
+		auto lo = _mm256_unpacklo_ps(even, odd);
+		auto hi = _mm256_unpackhi_ps(even, odd);
+		_mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(p + WIDTH, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+};
+
+/// Vector traits for 8 32bit integers in avx register
+struct Avx2Int
+{
+	typedef __m256i type;
+	static const size_t WIDTH = 8;
+
+	static type load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(int32_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static type set1(int32_t v) { return _mm256_set1_epi32(v); }
+	static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+	static type sub(type a, type b) { return _mm256_sub_epi32(a, b); }
+	static type sra1(type a) { return _mm256_srai_epi32(a, 1); }
+	static type sra2(type a) { return _mm256_srai_epi32(a, 2); }
+
+	static type shiftIn(type cur, type prev) {
+		// alignr works in 128b lanes, so feed it high lane of prev and low lane of cur
+		auto crossed = _mm256_permute2x128_si256(prev, cur, 0x21);
+		return _mm256_alignr_epi8(cur, crossed, 12);
+	}
+
+	static void deinterleave(const int32_t* p, type& even, type& odd) {
+		__m256 e, o;
+		Avx2Float::deinterleave(reinterpret_cast<const float*>(p), e, o);
+		even = _mm256_castps_si256(e);
+		odd = _mm256_castps_si256(o);
+	}
+
+	static void interleave(int32_t* p, type even, type odd) {
+		Avx2Float::interleave(reinterpret_cast<float*>(p), _mm256_castsi256_ps(even), _mm256_castsi256_ps(odd));
+	}
+};
+
+} // namespace
+
+void cdf97ForwardAvx2(float* signal, float* temp, size_t n, const float* coefs) {
+	cdf97Forward<Avx2Float>(signal, temp, n, coefs);
+}
+
+void cdf97InverseAvx2(float* dwt, float* temp, size_t n, const float* coefs) {
+	cdf97Inverse<Avx2Float>(dwt, temp, n, coefs);
+}
+
+void cdf53ForwardAvx2(int32_t* signal, int32_t* temp, size_t n) {
+	cdf53Forward<Avx2Int>(signal, temp, n);
+}
+
+void cdf53InverseAvx2(int32_t* dwt, int32_t* temp, size_t n) {
+	cdf53Inverse<Avx2Int>(dwt, temp, n);
+}
+
+#endif // WAVELET_SIMD_X86
@@ -0,0 +1,36 @@
+/**
+ * @file liftingkernels.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef LIFTING_KERNELS_H
+#define LIFTING_KERNELS_H
+
+#include <cstdlib>
+#include <cstdint>
+
+// Vectorized one level lifting kernels. Every instruction set lives in its own
+// translation unit compiled with matching compiler flags (see CMakeLists.txt),
+// so these may be called only after checking detectSimdLevel() and only when
+// library was built with WAVELET_SIMD_X86 defined.
+//
+// Forward kernels take interleaved signal of even size n and replace it with
+// approx coefs in first half and detail coefs in second half. Inverse kernels
+// do the opposite. temp must point to at least n values of scratch space
+// (n / 2 values for cdf 5/3 kernels).
+
+void cdf97ForwardSse2(float* signal, float* temp, size_t n, const float* coefs);
+void cdf97InverseSse2(float* dwt, float* temp, size_t n, const float* coefs);
+
+void cdf97ForwardAvx2(float* signal, float* temp, size_t n, const float* coefs);
+void cdf97InverseAvx2(float* dwt, float* temp, size_t n, const float* coefs);
+
+void cdf53ForwardSse41(int32_t* signal, int32_t* temp, size_t n);
+void cdf53InverseSse41(int32_t* dwt, int32_t* temp, size_t n);
+
+void cdf53ForwardAvx2(int32_t* signal, int32_t* temp, size_t n);
+void cdf53InverseAvx2(int32_t* dwt, int32_t* temp, size_t n);
+
+#endif // !LIFTING_KERNELS_H
@@ -0,0 +1,341 @@
+/**
+ * @file liftingscheme.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef LIFTING_SCHEME_H
+#define LIFTING_SCHEME_H
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+// Compile time description of wavelet lifting scheme. Scheme is class with
+// following members:
+//   value_type          type of samples
+//   Step0 .. Step3      lifting step policies, even steps are predicts and
+//                       odd steps are updates, unused steps are NoStep
+//   Scaling             scaling policy applied after lifting
+//
+// Step policy has static function delta(a, b, c, d) that returns value added
+// to lifted sample, undoing the step subtracts it. For predict of odd sample i
+// arguments are even samples i - 1, i, i + 1, i + 2, for update of even sample
+// i they are odd samples i - 2, i - 1, i, i + 1. Signal is extended
+// symmetrically at both ends.
+//
+// Scaling policy has static functions approx(even) and detail(odd) that
+// scale lifted samples and even(approx) and odd(detail) that undo it.
+//
+// All policies are plain static functions, so LiftingEngine that runs them
+// is fully inlined and there are no indirect calls per sample or per row.
+
+/// Placeholder for unused lifting steps.
+struct NoStep { };
+
+/// Scaling policy for schemes that aren't scaled.
+struct NoScaling
+{
+	template <typename T> static T approx(T even) { return even; }
+	template <typename T> static T detail(T odd) { return odd; }
+	template <typename T> static T even(T approx) { return approx; }
+	template <typename T> static T odd(T detail) { return detail; }
+};
+
+/**
+ * Base of lifting schemes, that defines steps.
+ * Schemes derive from it and add value_type and Scaling.
+ */
+template <class S0, class S1, class S2 = NoStep, class S3 = NoStep>
+struct LiftingSteps
+{
+	typedef S0 Step0;
+	typedef S1 Step1;
+	typedef S2 Step2;
+	typedef S3 Step3;
+
+	static const size_t NUM_STEPS = 2 + (std::is_same<S2, NoStep>::value ? 0 : 1) +
+		(std::is_same<S3, NoStep>::value ? 0 : 1);
+};
+
+/// Index of even sample j of signal with half even samples after symmetric extension.
+inline size_t liftingMirrorEven(ptrdiff_t j, size_t half) {
+	ptrdiff_t n = static_cast<ptrdiff_t>(half);
+	while (j < 0 || j >= n)
+		j = j < 0 ? -j : 2 * n - 1 - j;
+	return static_cast<size_t>(j);
+}
+
+/// Index of odd sample j of signal with half odd samples after symmetric extension.
+inline size_t liftingMirrorOdd(ptrdiff_t j, size_t half) {
+	ptrdiff_t n = static_cast<ptrdiff_t>(half);
+	while (j < 0 || j >= n)
+		j = j < 0 ? -j - 1 : 2 * n - 2 - j;
+	return static_cast<size_t>(j);
+}
+
+/**
+ * Applies one lifting step policy to signal split to halves, or to rows
+ * of split strip of columns.
+ * @tparam PREDICT true when step modifies odd samples from even ones
+ */
+template <class Step, bool PREDICT>
+struct LiftingStep
+{
+	/// offset of first neighbour of lifted sample i
+	static const ptrdiff_t FIRST = PREDICT ? -1 : -2;
+
+	static size_t mirror(ptrdiff_t j, size_t half) {
+		return PREDICT ? liftingMirrorEven(j, half) : liftingMirrorOdd(j, half);
+	}
+
+	template <typename T>
+	static void apply(const T* src, T* dst, size_t half, bool undo) {
+		if (undo)
+			lift<T, true>(src, dst, half);
+		else
+			lift<T, false>(src, dst, half);
+	}
+
+	template <typename T, bool UNDO>
+	static void lift(const T* src, T* dst, size_t half) {
+		// samples in [begin, end) have all neighbours inside of signal
+		size_t begin = static_cast<size_t>(-FIRST);
+		size_t last = static_cast<size_t>(3 + FIRST);
+		size_t end = half > begin + last ? half - last : begin;
+
+		for (size_t i = 0; i < begin && i < half; ++i)
+			liftBorder<T, UNDO>(src, dst, half, i);
+		for (size_t i = begin; i < end; ++i) {
+			const T* n = src + i + FIRST;
+			T delta = Step::delta(n[0], n[1], n[2], n[3]);
+			dst[i] = UNDO ? dst[i] - delta : dst[i] + delta;
+		}
+		for (size_t i = end; i < half; ++i)
+			liftBorder<T, UNDO>(src, dst, half, i);
+	}
+
+	template <typename T, bool UNDO>
+	static void liftBorder(const T* src, T* dst, size_t half, size_t i) {
+		ptrdiff_t j = static_cast<ptrdiff_t>(i) + FIRST;
+		T delta = Step::delta(src[mirror(j, half)], src[mirror(j + 1, half)],
+			src[mirror(j + 2, half)], src[mirror(j + 3, half)]);
+		dst[i] = UNDO ? dst[i] - delta : dst[i] + delta;
+	}
+
+	/// Lifts rows of strip, every row has width samples and rows start pitch samples apart.
+	template <typename T>
+	static void applyRows(const T* src, T* dst, size_t half, size_t width, size_t pitch, bool undo) {
+		for (size_t i = 0; i < half; ++i) {
+			ptrdiff_t j = static_cast<ptrdiff_t>(i) + FIRST;
+			const T* rows[4] = {
+				src + mirror(j, half) * pitch, src + mirror(j + 1, half) * pitch,
+				src + mirror(j + 2, half) * pitch, src + mirror(j + 3, half) * pitch
+			};
+			applyLine(rows, dst + i * pitch, width, undo);
+		}
+	}
+
+	/// Lifts target row using its four neighbour rows.
+	template <typename T>
+	static void applyLine(const T* const* rows, T* target, size_t width, bool undo) {
+		const T* a = rows[0];
+		const T* b = rows[1];
+		const T* c = rows[2];
+		const T* d = rows[3];
+		if (undo) {
+			for (size_t x = 0; x < width; ++x)
+				target[x] -= Step::delta(a[x], b[x], c[x], d[x]);
+		} else {
+			for (size_t x = 0; x < width; ++x)
+				target[x] += Step::delta(a[x], b[x], c[x], d[x]);
+		}
+	}
+};
+
+/// Unused steps do nothing.
+template <bool PREDICT>
+struct LiftingStep<NoStep, PREDICT>
+{
+	template <typename T> static void apply(const T*, T*, size_t, bool) { }
+	template <typename T> static void applyRows(const T*, T*, size_t, size_t, size_t, bool) { }
+	template <typename T> static void applyLine(const T* const*, T*, size_t, bool) { }
+};
+
+/**
+ * Generic lifting implementation of one dwt level for given scheme.
+ * Forward transform splits signal to even and odd halves, lifts them and
+ * stores scaled approx coefs to first half and detail coefs to second half.
+ */
+template <class Scheme>
+class LiftingEngine
+{
+public:
+	typedef typename Scheme::value_type value_type;
+	typedef typename Scheme::Scaling scaling_type;
+
+	static const size_t NUM_STEPS = Scheme::NUM_STEPS;
+
+	/**
+	 * One level of forward dwt of signal.
+	 * @param n even signal size
+	 * @param temp at least n values of scratch
+	 */
+	static void forward(value_type* signal, value_type* temp, size_t n) {
+		size_t half = n / 2;
+		value_type* even = temp;
+		value_type* odd = temp + half;
+		for (size_t i = 0; i < half; ++i) {
+			even[i] = signal[2 * i];
+			odd[i] = signal[2 * i + 1];
+		}
+
+		lift(even, odd, half, 1);
+
+		for (size_t i = 0; i < half; ++i) {
+			signal[i] = scaling_type::approx(even[i]);
+			signal[half + i] = scaling_type::detail(odd[i]);
+		}
+	}
+
+	/**
+	 * One level of inverse dwt.
+	 * @param n even signal size
+	 * @param temp at least n values of scratch
+	 */
+	static void inverse(value_type* dwt, value_type* temp, size_t n) {
+		size_t half = n / 2;
+		value_type* even = temp;
+		value_type* odd = temp + half;
+		for (size_t i = 0; i < half; ++i) {
+			even[i] = scaling_type::even(dwt[i]);
+			odd[i] = scaling_type::odd(dwt[half + i]);
+		}
+
+		unlift(even, odd, half, 1);
+
+		for (size_t i = 0; i < half; ++i) {
+			dwt[2 * i] = even[i];
+			dwt[2 * i + 1] = odd[i];
+		}
+	}
+
+	/**
+	 * One level of forward dwt of strip of columns, lifting runs on whole rows.
+	 * Rows are lifted in place, only detail rows pass through scratch when
+	 * they are moved to lower half.
+	 * @param temp at least height / 2 * width values of scratch
+	 */
+	static void forwardColumns(value_type* columns, size_t stride, size_t height, size_t width, value_type* temp) {
+		size_t half = height / 2;
+		lift(columns, columns + stride, half, width, 2 * stride);
+
+		// detail coefs wait in scratch, approx coefs move up to upper half,
+		// every row moves to row with lower or same index, so none is overwritten early
+		for (size_t i = 0; i < half; ++i) {
+			const value_type* odd = columns + (2 * i + 1) * stride;
+			for (size_t x = 0; x < width; ++x)
+				temp[i * width + x] = scaling_type::detail(odd[x]);
+		}
+		for (size_t i = 0; i < half; ++i) {
+			const value_type* even = columns + 2 * i * stride;
+			value_type* approxRow = columns + i * stride;
+			for (size_t x = 0; x < width; ++x)
+				approxRow[x] = scaling_type::approx(even[x]);
+		}
+		for (size_t i = 0; i < half; ++i)
+			memcpy(columns + (half + i) * stride, temp + i * width, width * sizeof(value_type));
+	}
+
+	/**
+	 * One level of inverse dwt of strip of columns.
+	 * @see forwardColumns
+	 */
+	static void inverseColumns(value_type* columns, size_t stride, size_t height, size_t width, value_type* temp) {
+		size_t half = height / 2;
+
+		// detail coefs wait in scratch, approx coefs move down to even rows from last one
+		for (size_t i = 0; i < half; ++i) {
+			const value_type* detailRow = columns + (half + i) * stride;
+			for (size_t x = 0; x < width; ++x)
+				temp[i * width + x] = scaling_type::odd(detailRow[x]);
+		}
+		for (size_t i = half; i-- > 0; ) {
+			const value_type* approxRow = columns + i * stride;
+			value_type* even = columns + 2 * i * stride;
+			for (size_t x = 0; x < width; ++x)
+				even[x] = scaling_type::even(approxRow[x]);
+		}
+		for (size_t i = 0; i < half; ++i)
+			memcpy(columns + (2 * i + 1) * stride, temp + i * width, width * sizeof(value_type));
+
+		unlift(columns, columns + stride, half, width, 2 * stride);
+	}
+
+	/**
+	 * Applies single lifting step to row.
+	 * @see Wavelet::liftLine
+	 */
+	static void liftLine(size_t step, bool undo, const value_type* const* rows, value_type* target, size_t width) {
+		switch (step)
+		{
+		case 0:
+			LiftingStep<typename Scheme::Step0, true>::applyLine(rows, target, width, undo);
+			break;
+		case 1:
+			LiftingStep<typename Scheme::Step1, false>::applyLine(rows, target, width, undo);
+			break;
+		case 2:
+			LiftingStep<typename Scheme::Step2, true>::applyLine(rows, target, width, undo);
+			break;
+		case 3:
+			LiftingStep<typename Scheme::Step3, false>::applyLine(rows, target, width, undo);
+			break;
+		default:
+			assert(false);
+		}
+	}
+
+	/**
+	 * Scales lifted rows to coefs or back.
+	 * @see Wavelet::scaleLines
+	 */
+	static void scaleLines(value_type* even, value_type* odd, size_t width, bool undo) {
+		for (size_t x = 0; x < width; ++x) {
+			even[x] = undo ? scaling_type::even(even[x]) : scaling_type::approx(even[x]);
+			odd[x] = undo ? scaling_type::odd(odd[x]) : scaling_type::detail(odd[x]);
+		}
+	}
+private:
+	/**
+	 * Runs all steps on split halves. Pitch 1 means halves are contiguous
+	 * signals, otherwise they are rows of strip lying pitch samples apart.
+	 */
+	static void lift(value_type* even, value_type* odd, size_t half, size_t width = 1, size_t pitch = 1) {
+		runStep<typename Scheme::Step0, true>(even, odd, half, width, pitch, false);
+		runStep<typename Scheme::Step1, false>(odd, even, half, width, pitch, false);
+		runStep<typename Scheme::Step2, true>(even, odd, half, width, pitch, false);
+		runStep<typename Scheme::Step3, false>(odd, even, half, width, pitch, false);
+	}
+
+	/// Undoes all steps in reverse order.
+	static void unlift(value_type* even, value_type* odd, size_t half, size_t width = 1, size_t pitch = 1) {
+		runStep<typename Scheme::Step3, false>(odd, even, half, width, pitch, true);
+		runStep<typename Scheme::Step2, true>(even, odd, half, width, pitch, true);
+		runStep<typename Scheme::Step1, false>(odd, even, half, width, pitch, true);
+		runStep<typename Scheme::Step0, true>(even, odd, half, width, pitch, true);
+	}
+
+	template <class Step, bool PREDICT>
+	static void runStep(const value_type* src, value_type* dst, size_t half, size_t width, size_t pitch, bool undo) {
+		if (pitch == 1)
+			LiftingStep<Step, PREDICT>::apply(src, dst, half, undo);
+		else
+			LiftingStep<Step, PREDICT>::applyRows(src, dst, half, width, pitch, undo);
+	}
+};
+
+#endif // !LIFTING_SCHEME_H
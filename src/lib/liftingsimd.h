@@ -0,0 +1,272 @@
+/**
+ * @file liftingsimd.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef LIFTING_SIMD_H
+#define LIFTING_SIMD_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+// Instruction set independent lifting kernels written against vector traits.
+// This header is included only by liftingsse2.cpp, liftingavx2.cpp etc. which
+// supply traits class V with following members:
+//   type, WIDTH                 vector type and number of lanes
+//   load, store, set1           unaligned memory access and broadcast
+//   add, mul, div               lane wise arithmetic (float traits)
+//   add, sub, sra1, sra2        lane wise arithmetic (integer traits), sraN
+//                               is arithmetic shift right by N bits
+//   shiftIn(cur, prev)          returns prev[WIDTH - 1], cur[0], ..., cur[WIDTH - 2]
+//                               (integer traits only)
+//   deinterleave(p, even, odd)  loads 2*WIDTH values and splits them by parity
+//   interleave(p, even, odd)    inverse of deinterleave
+//
+// Lifting runs on signal split to even (approx) and odd (detail) halves, so
+// every step reads neighbours from contiguous memory instead of stride 2 and
+// scaled halves are directly the layout that forward transform must produce.
+
+/**
+ * Split interleaved signal to even and odd halves.
+ * @param half number of samples in each half
+ */
+template <class V, typename T>
+void liftSplit(const T* signal, T* even, T* odd, size_t half) {
+	size_t i = 0;
+	for (; i + V::WIDTH <= half; i += V::WIDTH) {
+		typename V::type e, o;
+		V::deinterleave(signal + 2 * i, e, o);
+		V::store(even + i, e);
+		V::store(odd + i, o);
+	}
+	for (; i < half; ++i) {
+		even[i] = signal[2 * i];
+		odd[i] = signal[2 * i + 1];
+	}
+}
+
+/**
+ * Merge even and odd halves to interleaved signal.
+ * @param half number of samples in each half
+ */
+template <class V, typename T>
+void liftMerge(const T* even, const T* odd, T* signal, size_t half) {
+	size_t i = 0;
+	for (; i + V::WIDTH <= half; i += V::WIDTH)
+		V::interleave(signal + 2 * i, V::load(even + i), V::load(odd + i));
+	for (; i < half; ++i) {
+		signal[2 * i] = even[i];
+		signal[2 * i + 1] = odd[i];
+	}
+}
+
+/**
+ * Predict step on split signal: odd[i] += coef * (even[i] + even[i + 1]).
+ * Last odd sample uses symmetric extension.
+ */
+template <class V>
+void liftPredict(const float* even, float* odd, size_t half, float coef) {
+	auto c = V::set1(coef);
+	size_t i = 0;
+	for (; i + V::WIDTH < half; i += V::WIDTH) {
+		auto sum = V::add(V::load(even + i), V::load(even + i + 1));
+		V::store(odd + i, V::add(V::load(odd + i), V::mul(c, sum)));
+	}
+	for (; i + 1 < half; ++i)
+		odd[i] += coef * (even[i] + even[i + 1]);
+	// symmetric extension
+	odd[half - 1] += 2 * coef * even[half - 1];
+}
+
+/**
+ * Update step on split signal: even[i] += coef * (odd[i - 1] + odd[i]).
+ * First even sample uses symmetric extension.
+ */
+template <class V>
+void liftUpdate(const float* odd, float* even, size_t half, float coef) {
+	auto c = V::set1(coef);
+	size_t i = 1;
+	for (; i + V::WIDTH <= half; i += V::WIDTH) {
+		auto sum = V::add(V::load(odd + i - 1), V::load(odd + i));
+		V::store(even + i, V::add(V::load(even + i), V::mul(c, sum)));
+	}
+	for (; i < half; ++i)
+		even[i] += coef * (odd[i - 1] + odd[i]);
+	// symmetric extension
+	even[0] += 2 * coef * odd[0];
+}
+
+/// Computes dst[i] = src[i] / divisor
+template <class V>
+void liftDivide(const float* src, float* dst, size_t n, float divisor) {
+	auto d = V::set1(divisor);
+	size_t i = 0;
+	for (; i + V::WIDTH <= n; i += V::WIDTH)
+		V::store(dst + i, V::div(V::load(src + i), d));
+	for (; i < n; ++i)
+		dst[i] = src[i] / divisor;
+}
+
+/// Computes dst[i] = src[i] * factor
+template <class V>
+void liftMultiply(const float* src, float* dst, size_t n, float factor) {
+	auto f = V::set1(factor);
+	size_t i = 0;
+	for (; i + V::WIDTH <= n; i += V::WIDTH)
+		V::store(dst + i, V::mul(V::load(src + i), f));
+	for (; i < n; ++i)
+		dst[i] = src[i] * factor;
+}
+
+/**
+ * One level of forward cdf 9/7 transform.
+ * Produces same values as scalar Cdf97Wavelet, only memory layout of
+ * computation differs.
+ */
+template <class V>
+void cdf97Forward(float* signal, float* temp, size_t n, const float* coefs) {
+	size_t half = n / 2;
+	float* even = temp;
+	float* odd = temp + half;
+
+	liftSplit<V>(signal, even, odd, half);
+
+	liftPredict<V>(even, odd, half, coefs[0]);
+	liftUpdate<V>(odd, even, half, coefs[1]);
+	liftPredict<V>(even, odd, half, coefs[2]);
+	liftUpdate<V>(odd, even, half, coefs[3]);
+
+	// scale and store result
+	float scaleCoef = 1.0f / coefs[4];
+	liftDivide<V>(even, signal, half, scaleCoef);
+	liftMultiply<V>(odd, signal + half, half, scaleCoef);
+}
+
+/**
+ * One level of inverse cdf 9/7 transform.
+ */
+template <class V>
+void cdf97Inverse(float* dwt, float* temp, size_t n, const float* coefs) {
+	size_t half = n / 2;
+	float* even = temp;
+	float* odd = temp + half;
+
+	// unscale
+	float scaleCoef = coefs[4];
+	liftDivide<V>(dwt, even, half, scaleCoef);
+	liftMultiply<V>(dwt + half, odd, half, scaleCoef);
+
+	liftUpdate<V>(odd, even, half, -coefs[3]);
+	liftPredict<V>(even, odd, half, -coefs[2]);
+	liftUpdate<V>(odd, even, half, -coefs[1]);
+	liftPredict<V>(even, odd, half, -coefs[0]);
+
+	liftMerge<V>(even, odd, dwt, half);
+}
+
+/**
+ * One level of forward cdf 5/3 transform with predict, update and split
+ * fused to single pass over signal.
+ * Approx coefs are written in place, because i-th approx coef is computed
+ * after samples up to 2i + 2 were read, only detail coefs go through temp.
+ * Bit exact with scalar Cdf53Wavelet.
+ */
+template <class V>
+void cdf53Forward(int32_t* signal, int32_t* temp, size_t n) {
+	size_t half = n / 2;
+	int32_t* detail = temp;
+
+	size_t i = 0;
+	if (half > V::WIDTH) {
+		// first approx coef uses symmetric extension d[-1] = d[0]
+		int32_t d0 = signal[1] - ((signal[0] + signal[2]) >> 1);
+		auto prevDetail = V::set1(d0);
+		auto two = V::set1(2);
+
+		for (; i + V::WIDTH < half; i += V::WIDTH) {
+			typename V::type even, odd, nextEven, unused;
+			V::deinterleave(signal + 2 * i, even, odd);
+			V::deinterleave(signal + 2 * i + 2, nextEven, unused);
+
+			// predict
+			auto d = V::sub(odd, V::sra1(V::add(even, nextEven)));
+			// update
+			auto dprev = V::shiftIn(d, prevDetail);
+			auto s = V::add(even, V::sra2(V::add(V::add(dprev, d), two)));
+
+			V::store(signal + i, s);
+			V::store(detail + i, d);
+			prevDetail = d;
+		}
+	}
+
+	for (; i < half; ++i) {
+		int32_t d;
+		if (i + 1 < half)
+			d = signal[2 * i + 1] - ((signal[2 * i] + signal[2 * i + 2]) >> 1);
+		else
+			d = signal[2 * i + 1] - ((2 * signal[2 * i]) >> 1);		// symmetric extension
+
+		int32_t dprev = i > 0 ? detail[i - 1] : d;
+		signal[i] = signal[2 * i] + ((dprev + d + 2) >> 2);
+		detail[i] = d;
+	}
+
+	memcpy(signal + half, detail, half * sizeof(int32_t));
+}
+
+/**
+ * One level of inverse cdf 5/3 transform with undo update, undo predict and
+ * merge fused to single pass.
+ * Approx coefs are first saved to temp, detail coefs are read in place, it's
+ * safe because output samples 2i, 2i + 1 never reach detail coef i + 1 that's
+ * still needed.
+ */
+template <class V>
+void cdf53Inverse(int32_t* dwt, int32_t* temp, size_t n) {
+	size_t half = n / 2;
+	int32_t* approx = temp;
+	const int32_t* detail = dwt + half;
+
+	memcpy(approx, dwt, half * sizeof(int32_t));
+
+	size_t i = 0;
+	if (half > V::WIDTH) {
+		auto prevDetail = V::set1(detail[0]);
+		auto two = V::set1(2);
+
+		for (; i + V::WIDTH < half; i += V::WIDTH) {
+			auto d = V::load(detail + i);
+			auto dnext = V::load(detail + i + 1);
+			auto dprev = V::shiftIn(d, prevDetail);
+
+			// undo update for even samples 2i and 2i + 2
+			auto even = V::sub(V::load(approx + i), V::sra2(V::add(V::add(dprev, d), two)));
+			auto nextEven = V::sub(V::load(approx + i + 1), V::sra2(V::add(V::add(d, dnext), two)));
+			// undo predict
+			auto odd = V::add(d, V::sra1(V::add(even, nextEven)));
+
+			V::interleave(dwt + 2 * i, even, odd);
+			prevDetail = d;
+		}
+	}
+
+	for (; i < half; ++i) {
+		int32_t d = detail[i];
+		int32_t even = approx[i] - ((i > 0 ? detail[i - 1] + d + 2 : 2 * d + 2) >> 2);
+		int32_t odd;
+		if (i + 1 < half) {
+			int32_t nextEven = approx[i + 1] - ((d + detail[i + 1] + 2) >> 2);
+			odd = d + ((even + nextEven) >> 1);
+		} else
+			odd = d + ((2 * even) >> 1);		// symmetric extension
+
+		dwt[2 * i] = even;
+		dwt[2 * i + 1] = odd;
+	}
+}
+
+#endif // !LIFTING_SIMD_H
@@ -0,0 +1,54 @@
+/**
+ * @file liftingsse2.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "liftingkernels.h"
+
+#ifdef WAVELET_SIMD_X86
+
+#include "liftingsimd.h"
+
+#include <emmintrin.h>
+
+namespace {
+
+/// Vector traits for 4 floats in sse register
+struct Sse2Float
+{
+	typedef __m128 type;
+	static const size_t WIDTH = 4;
+
+	static type load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, type v) { _mm_storeu_ps(p, v); }
+	static type set1(float v) { return _mm_set1_ps(v); }
+	static type add(type a, type b) { return _mm_add_ps(a, b); }
+	static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+	static type div(type a, type b) { return _mm_div_ps(a, b); }
+
+	static void deinterleave(const float* p, type& even, type& odd) {
+		auto lo = _mm_loadu_ps(p);
+		auto hi = _mm_loadu_ps(p + WIDTH);
+		even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	static void interleave(float* p, type even, type odd) {
+		_mm_storeu_ps(p, _mm_unpacklo_ps(even, odd));
+		_mm_storeu_ps(p + WIDTH, _mm_unpackhi_ps(even, odd));
+	}
+};
+
+} // namespace
+
+void cdf97ForwardSse2(float* signal, float* temp, size_t n, const float* coefs) {
+	cdf97Forward<Sse2Float>(signal, temp, n, coefs);
+}
+
+void cdf97InverseSse2(float* dwt, float* temp, size_t n, const float* coefs) {
+	cdf97Inverse<Sse2Float>(dwt, temp, n, coefs);
+}
+
+#endif // WAVELET_SIMD_X86
@@ -0,0 +1,59 @@
+/**
+ * @file liftingsse41.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "liftingkernels.h"
+
+#ifdef WAVELET_SIMD_X86
+
+#include "liftingsimd.h"
+
+#include <smmintrin.h>
+
+namespace {
+
+/// Vector traits for 4 32bit integers in sse register
+struct Sse41Int
+{
+	typedef __m128i type;
+	static const size_t WIDTH = 4;
+
+	static type load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void store(int32_t* p, type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	static type set1(int32_t v) { return _mm_set1_epi32(v); }
+	static type add(type a, type b) { return _mm_add_epi32(a, b); }
+	static type sub(type a, type b) { return _mm_sub_epi32(a, b); }
+	static type sra1(type a) { return _mm_srai_epi32(a, 1); }
+	static type sra2(type a) { return _mm_srai_epi32(a, 2); }
+
+	static type shiftIn(type cur, type prev) {
+		return _mm_alignr_epi8(cur, prev, 12);
+	}
+
+	static void deinterleave(const int32_t* p, type& even, type& odd) {
+		auto lo = _mm_castsi128_ps(load(p));
+		auto hi = _mm_castsi128_ps(load(p + WIDTH));
+		even = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		odd = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	static void interleave(int32_t* p, type even, type odd) {
+		store(p, _mm_unpacklo_epi32(even, odd));
+		store(p + WIDTH, _mm_unpackhi_epi32(even, odd));
+	}
+};
+
+} // namespace
+
+void cdf53ForwardSse41(int32_t* signal, int32_t* temp, size_t n) {
+	cdf53Forward<Sse41Int>(signal, temp, n);
+}
+
+void cdf53InverseSse41(int32_t* dwt, int32_t* temp, size_t n) {
+	cdf53Inverse<Sse41Int>(dwt, temp, n);
+}
+
+#endif // WAVELET_SIMD_X86
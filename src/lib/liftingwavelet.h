@@ -0,0 +1,73 @@
+/**
+ * @file liftingwavelet.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef LIFTING_WAVELET_H
+#define LIFTING_WAVELET_H
+
+#include "wavelet.h"
+#include "liftingscheme.h"
+
+/**
+ * Wavelet implemented by generic lifting engine.
+ * All methods are defined here, so when transform knows concrete wavelet
+ * type it calls them directly and they get inlined to its loops.
+ * @tparam Scheme lifting scheme description, see liftingscheme.h
+ */
+template <class Scheme>
+class LiftingWavelet : public Wavelet<typename Scheme::value_type>
+{
+public:
+	typedef typename Scheme::value_type value_type;
+	typedef Scheme scheme_type;
+	typedef LiftingEngine<Scheme> engine_type;
+
+	using Wavelet<value_type>::forward;
+	using Wavelet<value_type>::inverse;
+
+	virtual void forward(ArrayRef<value_type> signal, ArrayRef<value_type> scratch) const {
+		assert(signal.size() % 2 == 0);
+		assert(scratch.size() >= signal.size());
+		engine_type::forward(signal.data(), scratch.data(), signal.size());
+	}
+
+	virtual void inverse(ArrayRef<value_type> dwt, ArrayRef<value_type> scratch) const {
+		assert(dwt.size() % 2 == 0);
+		assert(scratch.size() >= dwt.size());
+		engine_type::inverse(dwt.data(), scratch.data(), dwt.size());
+	}
+
+	virtual void forwardColumns(value_type* columns, size_t stride, size_t height, size_t width,
+		ArrayRef<value_type> scratch) const {
+
+		assert(height % 2 == 0);
+		assert(scratch.size() >= height * width);
+		engine_type::forwardColumns(columns, stride, height, width, scratch.data());
+	}
+
+	virtual void inverseColumns(value_type* columns, size_t stride, size_t height, size_t width,
+		ArrayRef<value_type> scratch) const {
+
+		assert(height % 2 == 0);
+		assert(scratch.size() >= height * width);
+		engine_type::inverseColumns(columns, stride, height, width, scratch.data());
+	}
+
+	virtual size_t numLiftingSteps() const {
+		return engine_type::NUM_STEPS;
+	}
+
+	virtual void liftLine(size_t step, bool undo, const value_type* const* rows, value_type* target, size_t width) const {
+		assert(step < engine_type::NUM_STEPS);
+		engine_type::liftLine(step, undo, rows, target, width);
+	}
+
+	virtual void scaleLines(value_type* even, value_type* odd, size_t width, bool undo) const {
+		engine_type::scaleLines(even, odd, width, undo);
+	}
+};
+
+#endif // !LIFTING_WAVELET_H
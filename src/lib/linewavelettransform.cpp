@@ -0,0 +1,324 @@
+/**
+ * @file linewavelettransform.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "linewavelettransform.h"
+#include "liftingscheme.h"
+
+#include <deque>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+/**
+ * Vertical lifting of one level done on sliding window of row pairs.
+ * Pair i holds even row 2i and odd row 2i + 1. Lifting steps are applied
+ * to pairs as soon as their neighbours are lifted far enough and pair leaves
+ * window when no other pair needs it anymore.
+ */
+template <typename T>
+class LiftingPipeline
+{
+public:
+	struct RowPair
+	{
+		std::vector<T> even, odd;
+		size_t stage;		/// number of lifting steps applied so far
+	};
+
+	LiftingPipeline(const Wavelet<T>& wavelet, bool undo, size_t width, size_t numPairs) : wavelet(wavelet),
+		undo(undo), width(width), numPairs(numPairs), first(0), received(0), allocated(0) {
+
+		// inverse transform undoes steps in reverse order
+		size_t numSteps = wavelet.numLiftingSteps();
+		for (size_t i = 0; i < numSteps; ++i)
+			steps.push_back(undo ? numSteps - 1 - i : i);
+		next.resize(numSteps, 0);
+	}
+
+	/// Get empty pair that can be filled and pushed.
+	RowPair take() {
+		if (unused.empty()) {
+			allocated++;
+			RowPair pair;
+			pair.even.resize(width);
+			pair.odd.resize(width);
+			pair.stage = 0;
+			return pair;
+		}
+
+		RowPair pair = std::move(unused.back());
+		unused.pop_back();
+		pair.stage = 0;
+		return pair;
+	}
+
+	/// Returns pair taken by take() or pop() back for reuse.
+	void recycle(RowPair pair) {
+		unused.push_back(std::move(pair));
+	}
+
+	/// Appends next pair and lifts everything that can be lifted.
+	void push(RowPair pair) {
+		assert(received < numPairs);
+		window.push_back(std::move(pair));
+		received++;
+		lift();
+	}
+
+	/// Checks whether first pair in window is fully lifted and no longer needed.
+	bool ready() const {
+		if (window.empty() || window.front().stage < steps.size())
+			return false;
+		// following pairs within reach read our rows while they're lifted
+		for (size_t k = 1; k <= REACH && first + k < numPairs; ++k) {
+			if (k >= window.size() || window[k].stage < steps.size())
+				return false;
+		}
+		return true;
+	}
+
+	/// Removes first pair from window, it must be ready.
+	RowPair pop() {
+		assert(ready());
+		RowPair pair = std::move(window.front());
+		window.pop_front();
+		first++;
+		return pair;
+	}
+
+	size_t allocatedValues() const {
+		return allocated * 2 * width;
+	}
+private:
+	RowPair& at(size_t i) {
+		assert(i >= first && i < received);
+		return window[i - first];
+	}
+
+	/**
+	 * Checks that step s can be applied to pair i. Every pair within reach
+	 * must be lifted up to step s, so neighbours that pair i reads are in
+	 * right state and pairs that read pair i in step s - 1 already did so.
+	 */
+	bool canLift(size_t s, size_t i) {
+		if (i >= received || at(i).stage != s)
+			return false;
+		for (size_t k = i + 1; k <= i + REACH && k < numPairs; ++k) {
+			if (k >= received || at(k).stage < s)
+				return false;
+		}
+		return true;
+	}
+
+	void lift() {
+		bool progress = true;
+		while (progress) {
+			progress = false;
+			for (size_t s = 0; s < steps.size(); ++s) {
+				size_t i = next[s];
+				if (!canLift(s, i))
+					continue;
+
+				RowPair& pair = at(i);
+				size_t step = steps[s];
+				ptrdiff_t j = static_cast<ptrdiff_t>(i);
+				const T* rows[4];
+				if (step % 2 == 0) {
+					// predict of odd row from even rows i - 1 .. i + 2
+					for (int k = 0; k < 4; ++k)
+						rows[k] = at(liftingMirrorEven(j - 1 + k, numPairs)).even.data();
+					wavelet.liftLine(step, undo, rows, pair.odd.data(), width);
+				} else {
+					// update of even row from odd rows i - 2 .. i + 1
+					for (int k = 0; k < 4; ++k)
+						rows[k] = at(liftingMirrorOdd(j - 2 + k, numPairs)).odd.data();
+					wavelet.liftLine(step, undo, rows, pair.even.data(), width);
+				}
+
+				pair.stage++;
+				next[s]++;
+				progress = true;
+			}
+		}
+	}
+
+	/// how far neighbour rows of lifting step can be
+	static const size_t REACH = 2;
+
+	const Wavelet<T>& wavelet;
+	bool undo;
+	size_t width;
+	size_t numPairs;
+	std::vector<size_t> steps;		/// wavelet lifting step for every pipeline stage
+	std::vector<size_t> next;		/// index of next pair for every stage
+	std::deque<RowPair> window;
+	std::vector<RowPair> unused;
+	size_t first;					/// index of first pair in window
+	size_t received;				/// number of pushed pairs
+	size_t allocated;				/// number of allocated pairs
+};
+
+template <typename T>
+class LineWaveletTransform<T>::Level
+{
+public:
+	typedef typename LiftingPipeline<T>::RowPair RowPair;
+
+	Level(const wavelet_type& wavelet, bool undo, size_t width, size_t height) : width(width), height(height),
+		rows(0), pairs(0), pipeline(wavelet, undo, width, height / 2),
+		scratch(wavelet_type::scratchSize(width)), oddNext(false) { }
+
+	size_t width, height;
+	size_t rows;				/// number of rows pushed to forward transform
+	size_t pairs;				/// number of pairs that left (forward) or entered (inverse) pipeline
+	LiftingPipeline<T> pipeline;
+	std::vector<T> scratch;
+	RowPair pending;			/// pair that is being filled by forward transform
+	std::deque<RowPair> done;	/// reconstructed pairs waiting for pullRow
+	bool oddNext;				/// whether odd row of first done pair is next
+};
+
+template <typename T>
+LineWaveletTransform<T>::LineWaveletTransform(const std::shared_ptr<wavelet_type>& wavelet, int numLevels,
+	size_t width, size_t height) : wavelet(wavelet), numLevels(numLevels), width(width), height(height) {
+
+	size_t factor = static_cast<size_t>(1) << numLevels;
+	if (width % factor != 0 || height % factor != 0)
+		throw std::runtime_error("LineWaveletTransform: image size must be divisible by 2^numLevels!");
+}
+
+template <typename T>
+LineWaveletTransform<T>::~LineWaveletTransform() { }
+
+template <typename T>
+void LineWaveletTransform<T>::reset() {
+	levels.clear();
+}
+
+template <typename T>
+void LineWaveletTransform<T>::beginForward(const CoefSink& sink) {
+	reset();
+	coefSink = sink;
+
+	for (int i = 0; i < numLevels; ++i)
+		levels.push_back(std::unique_ptr<Level>(new Level(*wavelet, false, width >> i, height >> i)));
+}
+
+template <typename T>
+void LineWaveletTransform<T>::pushRow(const value_type* row) {
+	if (levels.empty() || levels[0]->rows >= height)
+		throw std::runtime_error("LineWaveletTransform::pushRow: forward transform isn't running!");
+
+	pushRow(0, row);
+}
+
+template <typename T>
+void LineWaveletTransform<T>::pushRow(size_t level, const value_type* row) {
+	Level& l = *levels[level];
+
+	if (l.rows % 2 == 0)
+		l.pending = l.pipeline.take();
+
+	// horizontal transform right away, vertical lifting then works on whole rows
+	auto& dest = l.rows % 2 == 0 ? l.pending.even : l.pending.odd;
+	memcpy(dest.data(), row, l.width * sizeof(value_type));
+	wavelet->forward(ArrayRef<value_type>(dest.data(), l.width), l.scratch);
+	l.rows++;
+
+	if (l.rows % 2 != 0)
+		return;
+
+	l.pipeline.push(std::move(l.pending));
+	while (l.pipeline.ready()) {
+		typename Level::RowPair pair = l.pipeline.pop();
+		size_t i = l.pairs++;
+		size_t half = l.width / 2;
+		wavelet->scaleLines(pair.even.data(), pair.odd.data(), l.width, false);
+
+		// detail row and horizontal detail part of approx row are final
+		coefSink(l.height / 2 + i, 0, pair.odd.data(), l.width);
+		coefSink(i, half, pair.even.data() + half, half);
+
+		// approx part is input of next level
+		if (level + 1 < levels.size())
+			pushRow(level + 1, pair.even.data());
+		else
+			coefSink(i, 0, pair.even.data(), half);
+
+		l.pipeline.recycle(std::move(pair));
+	}
+}
+
+template <typename T>
+void LineWaveletTransform<T>::inverse(const CoefSource& source, const RowSink& sink) {
+	reset();
+	coefSource = source;
+
+	for (int i = 0; i < numLevels; ++i)
+		levels.push_back(std::unique_ptr<Level>(new Level(*wavelet, true, width >> i, height >> i)));
+
+	std::vector<value_type> row(width);
+	for (size_t y = 0; y < height; ++y) {
+		pullRow(0, row.data());
+		sink(y, row.data());
+	}
+}
+
+template <typename T>
+void LineWaveletTransform<T>::pullRow(size_t level, value_type* row) {
+	Level& l = *levels[level];
+
+	while (l.done.empty()) {
+		assert(l.pairs < l.height / 2);
+
+		typename Level::RowPair pair = l.pipeline.take();
+		size_t i = l.pairs++;
+		size_t half = l.width / 2;
+
+		// approx part comes from next level
+		if (level + 1 < levels.size())
+			pullRow(level + 1, pair.even.data());
+		else
+			coefSource(i, 0, pair.even.data(), half);
+		coefSource(i, half, pair.even.data() + half, half);
+		coefSource(l.height / 2 + i, 0, pair.odd.data(), l.width);
+
+		wavelet->scaleLines(pair.even.data(), pair.odd.data(), l.width, true);
+		l.pipeline.push(std::move(pair));
+
+		while (l.pipeline.ready()) {
+			typename Level::RowPair lifted = l.pipeline.pop();
+			wavelet->inverse(ArrayRef<value_type>(lifted.even.data(), l.width), l.scratch);
+			wavelet->inverse(ArrayRef<value_type>(lifted.odd.data(), l.width), l.scratch);
+			l.done.push_back(std::move(lifted));
+		}
+	}
+
+	typename Level::RowPair& pair = l.done.front();
+	if (!l.oddNext) {
+		memcpy(row, pair.even.data(), l.width * sizeof(value_type));
+		l.oddNext = true;
+	} else {
+		memcpy(row, pair.odd.data(), l.width * sizeof(value_type));
+		l.oddNext = false;
+		l.pipeline.recycle(std::move(pair));
+		l.done.pop_front();
+	}
+}
+
+template <typename T>
+size_t LineWaveletTransform<T>::bufferedValues() const {
+	size_t result = 0;
+	for (auto& level : levels)
+		result += level->pipeline.allocatedValues() + level->scratch.size();
+	return result;
+}
+
+// this is explicit template instantiation
+// we must use this because we have template implementation in cpp file
+template class LineWaveletTransform<int32_t>;
+template class LineWaveletTransform<float>;
@@ -0,0 +1,98 @@
+/**
+ * @file linewavelettransform.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef LINE_WAVELET_TRANSFORM_H
+#define LINE_WAVELET_TRANSFORM_H
+
+#include "wavelet.h"
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Line based 2d wavelet transform.
+ * Unlike WaveletTransform it doesn't need whole image in memory. Forward
+ * transform consumes image row by row and hands out coefs as soon as they
+ * are final, inverse transform pulls coefs when it needs them and produces
+ * image rows in order. Every level keeps only sliding window of rows that
+ * its lifting steps need, so memory grows with width, filter length and
+ * number of levels, but not with image height.
+ * Coefs are addressed in same layout as WaveletTransform::forward2d produces.
+ * @tparam T type on which transform operates (currently only float and int32_t allowed)
+ */
+template <typename T>
+class LineWaveletTransform
+{
+public:
+	typedef T value_type;
+	typedef Wavelet<value_type> wavelet_type;
+
+	/// Receives count final coefs of dwt row y starting at column x.
+	typedef std::function<void (size_t y, size_t x, const value_type* coefs, size_t count)> CoefSink;
+
+	/// Fills count coefs of dwt row y starting at column x.
+	typedef std::function<void (size_t y, size_t x, value_type* coefs, size_t count)> CoefSource;
+
+	/// Receives reconstructed image row y, rows come in top to bottom order.
+	typedef std::function<void (size_t y, const value_type* row)> RowSink;
+
+	/**
+	 * Creates transform for image of given size.
+	 * @throws std::runtime_error when width or height isn't divisible by 2^numLevels
+	 */
+	LineWaveletTransform(const std::shared_ptr<wavelet_type>& wavelet, int numLevels, size_t width, size_t height);
+
+	~LineWaveletTransform();
+
+	/**
+	 * Starts forward transform, previous unfinished transform is discarded.
+	 * @param sink receives coefs, all of them are passed after last row is pushed
+	 */
+	void beginForward(const CoefSink& sink);
+
+	/**
+	 * Pushes next image row to forward transform.
+	 * @param row width values
+	 * @throws std::runtime_error when all rows were already pushed
+	 */
+	void pushRow(const value_type* row);
+
+	/**
+	 * Computes inverse transform.
+	 * @param source supplies coefs, every coef is requested exactly once
+	 * @param sink receives reconstructed rows
+	 */
+	void inverse(const CoefSource& source, const RowSink& sink);
+
+	/// Get number of values currently allocated for row buffers of all levels.
+	size_t bufferedValues() const;
+private:
+	class Level;
+
+	void reset();
+	void pushRow(size_t level, const value_type* row);
+	void pullRow(size_t level, value_type* row);
+
+	std::shared_ptr<wavelet_type> wavelet;
+	int numLevels;
+	size_t width, height;
+	std::vector<std::unique_ptr<Level>> levels;
+	CoefSink coefSink;
+	CoefSource coefSource;
+
+	LineWaveletTransform(const LineWaveletTransform&);
+	LineWaveletTransform& operator=(const LineWaveletTransform&);
+};
+
+// Extern template instantiation, actual instantiation is done in
+// linewavelettransform.cpp
+extern template class LineWaveletTransform<int32_t>;
+extern template class LineWaveletTransform<float>;
+
+#endif // !LINE_WAVELET_TRANSFORM_H
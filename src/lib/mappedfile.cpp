@@ -0,0 +1,121 @@
+/**
+ * @file mappedfile.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "mappedfile.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static std::runtime_error openError(const char* file) {
+	return std::runtime_error("Unable to open file\"" + std::string(file) + "\" for reading!");
+}
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const char* file) : begin(nullptr), length(0), mapping(nullptr) {
+	HANDLE handle = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		throw openError(file);
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize)) {
+		CloseHandle(handle);
+		throw openError(file);
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+
+	// empty file can't be mapped, it doesn't need to
+	if (length != 0) {
+		mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+			begin = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	CloseHandle(handle);
+
+	if (length != 0 && begin == nullptr) {
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		throw std::runtime_error("Unable to map file\"" + std::string(file) + "\" to memory!");
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (mapping != nullptr) {
+		UnmapViewOfFile(begin);
+		CloseHandle(mapping);
+	}
+}
+
+#elif defined(MAPPED_FILE_POSIX)
+
+MappedFile::MappedFile(const char* file) : begin(nullptr), length(0), mapping(nullptr) {
+	int fd = open(file, O_RDONLY);
+	if (fd < 0)
+		throw openError(file);
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw openError(file);
+	}
+	length = static_cast<size_t>(info.st_size);
+
+	// empty file can't be mapped, it doesn't need to
+	if (length != 0) {
+		void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("Unable to map file\"" + std::string(file) + "\" to memory!");
+		}
+
+		// whole file is decoded from start to end
+		madvise(addr, length, MADV_SEQUENTIAL);
+		mapping = addr;
+		begin = static_cast<const uint8_t*>(addr);
+	}
+	// mapping stays valid after file is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (mapping != nullptr)
+		munmap(mapping, length);
+}
+
+#else
+
+MappedFile::MappedFile(const char* file) : begin(nullptr), length(0), mapping(nullptr) {
+	std::ifstream in(file, std::ios_base::binary);
+	if (!in)
+		throw openError(file);
+
+	in.seekg(0, std::ios_base::end);
+	contents.resize(static_cast<size_t>(in.tellg()));
+	in.seekg(0);
+	in.read(reinterpret_cast<char*>(contents.data()), contents.size());
+	if (!in)
+		throw openError(file);
+
+	begin = contents.data();
+	length = contents.size();
+}
+
+MappedFile::~MappedFile() { }
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file mappedfile.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Read only file mapped to memory.
+ * Contents are accessed straight from page cache without copying to
+ * buffers. Where mapping isn't available whole file is read to memory.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * Maps file to memory.
+	 * @param file path
+	 * @throws std::runtime_error when file can't be opened or mapped
+	 */
+	explicit MappedFile(const char* file);
+
+	~MappedFile();
+
+	const uint8_t* data() const {
+		return begin;
+	}
+
+	size_t size() const {
+		return length;
+	}
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const uint8_t* begin;
+	size_t length;
+	void* mapping;					/// system mapping handle, null when file isn't mapped
+	std::vector<uint8_t> contents;	/// file read to memory when it can't be mapped
+};
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,41 @@
+/**
+ * @file rangedecoder.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "rangedecoder.h"
+
+/// size of input block read from stream at once
+static const size_t BUFFER_SIZE = 1 << 16;
+
+RangeDecoder::RangeDecoder(std::istream* stream) : stream(stream), next(nullptr), end(nullptr),
+	code(0), range(0xffffffff) {
+
+	start();
+}
+
+RangeDecoder::RangeDecoder(const uint8_t* data, size_t size) : stream(nullptr), next(data), end(data + size),
+	code(0), range(0xffffffff) {
+
+	start();
+}
+
+void RangeDecoder::start() {
+	// first byte is always zero cache of encoder, it's shifted out of code
+	for (int i = 0; i < 5; ++i)
+		code = (code << 8) | nextByte();
+}
+
+bool RangeDecoder::fillBuffer() {
+	if (stream == nullptr)
+		return false;
+
+	buffer.resize(BUFFER_SIZE);
+	stream->read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+	buffer.resize(static_cast<size_t>(stream->gcount()));
+	next = buffer.data();
+	end = next + buffer.size();
+	return !buffer.empty();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file rangedecoder.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef RANGEDECODER_H
+#define RANGEDECODER_H
+
+#include "arithmcodec.h"
+
+#include <iostream>
+#include <vector>
+
+/**
+ * Byte oriented range decoder, counterpart of RangeEncoder.
+ * Input is read from memory buffer or from stream in big blocks, zero
+ * bytes are used past its end.
+ */
+class RangeDecoder
+{
+public:
+	/**
+	 * Constructs new decoder and reads start of code.
+	 * @param stream input stream
+	 */
+	explicit RangeDecoder(std::istream* stream);
+
+	/**
+	 * Constructs new decoder of memory buffer and reads start of code.
+	 * @param data buffer with code, it has to live as long as decoder
+	 * @param size size of buffer in bytes
+	 */
+	RangeDecoder(const uint8_t* data, size_t size);
+
+	/**
+	 * Decodes symbol with data model, see ArithmeticDecoder::decode.
+	 * @param model data model with frequencies, it's updated after symbol is decoded
+	 * @return decoded symbol
+	 */
+	template <class Model>
+	unsigned decode(Model& model) {
+		assert(model.totalFreq() <= RangeCoderTraits::MAX_TOTAL);
+
+		uint32_t r = range / model.totalFreq();
+		// code past last symbol interval can't be produced by encoder, just don't crash on it
+		uint32_t freq = std::min(code / r, model.totalFreq() - 1);
+		unsigned symbol = model.findSymbol(freq);
+
+		auto lowFreq = model.lowFreq(symbol);
+		code -= r * lowFreq;
+		range = r * (model.highFreq(symbol) - lowFreq);
+
+		while (range < RangeCoderTraits::BOTTOM) {
+			range <<= 8;
+			code = (code << 8) | nextByte();
+		}
+
+		model.update(symbol);
+		return symbol;
+	}
+private:
+	uint8_t nextByte() {
+		if (next == end && !fillBuffer())
+			return 0;
+		return *next++;
+	}
+
+	/// Reads next block of stream, returns false on its end.
+	bool fillBuffer();
+
+	/// Reads first bytes of code.
+	void start();
+
+	std::istream* stream;			/// null when decoding memory buffer
+	std::vector<uint8_t> buffer;	/// block of stream being decoded
+	const uint8_t* next;			/// position of next byte
+	const uint8_t* end;
+
+	uint32_t code;					/// code value relative to low bound of interval
+	uint32_t range;
+};
+
+#endif // !RANGEDECODER_H
@@ -0,0 +1,60 @@
+/**
+ * @file rangeencoder.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "rangeencoder.h"
+
+#include <stdexcept>
+
+/// size of output block written to stream at once
+static const size_t BUFFER_SIZE = 1 << 16;
+
+RangeEncoder::RangeEncoder(std::ostream* stream) : stream(stream), output(&buffer), low(0), range(0xffffffff),
+	cache(0), cacheSize(1), closed(false) {
+
+	buffer.reserve(BUFFER_SIZE);
+}
+
+RangeEncoder::RangeEncoder(std::vector<uint8_t>* buffer) : stream(nullptr), output(buffer), low(0), range(0xffffffff),
+	cache(0), cacheSize(1), closed(false) { }
+
+void RangeEncoder::close() {
+	if (closed)
+		return;
+
+	// push out all bytes of low
+	for (int i = 0; i < 5; ++i)
+		shiftLow();
+
+	if (stream != nullptr)
+		flushBuffer();
+	closed = true;
+}
+
+void RangeEncoder::shiftLow() {
+	// top byte is final when it can't get carry anymore or carry already came
+	if (static_cast<uint32_t>(low) < 0xff000000U || (low >> 32) != 0) {
+		uint8_t carry = static_cast<uint8_t>(low >> 32);
+		uint8_t byte = cache;
+		do {
+			output->push_back(static_cast<uint8_t>(byte + carry));
+			byte = 0xff;
+		} while (--cacheSize != 0);
+		cache = static_cast<uint8_t>(low >> 24);
+
+		if (stream != nullptr && buffer.size() >= BUFFER_SIZE)
+			flushBuffer();
+	}
+
+	cacheSize++;
+	low = (low & 0x00ffffff) << 8;
+}
+
+void RangeEncoder::flushBuffer() {
+	if (!stream->write(reinterpret_cast<const char*>(buffer.data()), buffer.size()))
+		throw std::runtime_error("Unable to write range coded data to stream!");
+	buffer.clear();
+}
@@ -0,0 +1,87 @@
+/**
+ * @file rangeencoder.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef RANGEENCODER_H
+#define RANGEENCODER_H
+
+#include "arithmcodec.h"
+
+#include <iostream>
+#include <vector>
+
+/**
+ * Byte oriented range encoder.
+ * Unlike ArithmeticEncoder it renormalizes by whole bytes, so it needs
+ * single check per byte instead of per bit, and output is collected
+ * in memory and written to stream in big blocks or appended to vector. Carry is propagated
+ * through cached byte and run of 0xff bytes like in LZMA.
+ * Models must not have sum of frequencies greater than RangeCoderTraits::MAX_TOTAL.
+ */
+class RangeEncoder
+{
+public:
+	/**
+	 * Constructs new encoder.
+	 * @param stream output stream, it has to live until encoder is closed
+	 */
+	explicit RangeEncoder(std::ostream* stream);
+
+	/**
+	 * Constructs new encoder that appends code to vector.
+	 * @param buffer output vector, it has to live until encoder is closed
+	 */
+	explicit RangeEncoder(std::vector<uint8_t>* buffer);
+
+	~RangeEncoder() {
+		close();
+	}
+
+	/**
+	 * Finishes encoding, writes rest of data to stream.
+	 * Encoder can't be used after this call.
+	 */
+	void close();
+
+	/**
+	 * Encodes given symbol with data model, see ArithmeticEncoder::encode.
+	 * @param symbol symbol from model to encode
+	 * @param model data model with frequencies, it's updated after symbol is coded
+	 */
+	template <class Model>
+	void encode(unsigned symbol, Model& model) {
+		assert(model.totalFreq() <= RangeCoderTraits::MAX_TOTAL);
+
+		uint32_t r = range / model.totalFreq();
+		auto lowFreq = model.lowFreq(symbol);
+		low += static_cast<uint64_t>(r) * lowFreq;
+		range = r * (model.highFreq(symbol) - lowFreq);
+
+		while (range < RangeCoderTraits::BOTTOM) {
+			range <<= 8;
+			shiftLow();
+		}
+
+		model.update(symbol);
+	}
+private:
+	/// Moves top byte of low to output, it's delayed until carry can't change it.
+	void shiftLow();
+
+	void flushBuffer();
+
+	std::ostream* stream;			/// null when encoding to vector
+	std::vector<uint8_t> buffer;	/// bytes waiting for write to stream
+	std::vector<uint8_t>* output;	/// vector where bytes are appended, buffer for stream
+
+	uint64_t low;				/// lower interval bound, bit 32 is carry
+	uint32_t range;
+	uint8_t cache;				/// last byte that may still be changed by carry
+	uint64_t cacheSize;			/// number of delayed bytes, cache and following 0xff bytes
+	bool closed;
+};
+
+#endif // !RANGEENCODER_H
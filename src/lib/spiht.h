@@ -0,0 +1,89 @@
+/**
+ * @file spiht.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef SPIHT_H
+#define SPIHT_H
+
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+/**
+ * Convenient base class of SpihtDecoder and SpihtEncoder.
+ * Contains spatial orientation tree and lists shared by encoding and
+ * decoding, and cannot be instantiated.
+ */
+class SpihtCodec
+{
+protected:
+	/// Entry of list of insignificant sets
+	struct SetItem
+	{
+		/// A is set of all descendants, B is set of descendants without offspring
+		enum class Type { A, B };
+
+		uint32_t index;		/// coef index in layout
+		Type type;
+
+		SetItem() { }
+		SetItem(uint32_t index, Type type) : index(index), type(type) { }
+	};
+
+	SpihtCodec() : cols(0), rows(0), rootCols(0), rootRows(0) { }
+
+	/**
+	 * Sets size of coded matrix and number of dwt levels in it.
+	 * When lowpass band of numlevels would be too small or matrix isn't
+	 * divisible by 2^numlevels, fewer levels are used, tree then just has
+	 * more roots.
+	 */
+	void setSize(size_t cols, size_t rows, int numlevels) {
+		while (numlevels > 0 && ((cols >> numlevels) < 2 || (rows >> numlevels) < 2 ||
+			cols % (static_cast<size_t>(1) << numlevels) != 0 || rows % (static_cast<size_t>(1) << numlevels) != 0))
+			numlevels--;
+
+		this->cols = cols;
+		this->rows = rows;
+		rootCols = cols >> numlevels;
+		rootRows = rows >> numlevels;
+	}
+
+	/// Checks whether coef is in lowpass band, that holds tree roots.
+	bool isRoot(size_t x, size_t y) const {
+		return x < rootCols && y < rootRows;
+	}
+
+	/**
+	 * Get first offspring of given coef.
+	 * You can obtain another 3 offspring by adding 1 to each coordinate.
+	 * Roots are grouped by 2x2, left up root of group doesn't have any
+	 * offspring and other roots point to same place in detail bands.
+	 * @return false when there are no offspring at all
+	 */
+	bool getOffspring(size_t x, size_t y, size_t& ox, size_t& oy) const {
+		if (isRoot(x, y)) {
+			if (x % 2 == 0 && y % 2 == 0)
+				return false;
+			ox = x % 2 != 0 ? x + rootCols - 1 : x;
+			oy = y % 2 != 0 ? y + rootRows - 1 : y;
+		} else {
+			ox = 2 * x;
+			oy = 2 * y;
+		}
+
+		return ox + 1 < cols && oy + 1 < rows;
+	}
+
+	size_t cols, rows;
+	size_t rootCols, rootRows;		/// size of lowpass band
+
+	std::vector<uint32_t> lip;		/// list of insignificant pixels
+	std::vector<uint32_t> lsp;		/// list of significant pixels
+	std::vector<SetItem> lis;		/// list of insignificant sets
+};
+
+#endif // !SPIHT_H
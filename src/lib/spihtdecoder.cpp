@@ -0,0 +1,137 @@
+/**
+ * @file spihtdecoder.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "spihtdecoder.h"
+
+#include <stdexcept>
+
+void SpihtDecoder::decode(int numlevels, int steps, int minStep, cv::Mat& img, CoefLayout layout) {
+	if (img.type() != CV_32S)
+		throw std::runtime_error("SpihtDecoder::decode can operate only on 32b integer matrices");
+
+	setSize(img.cols, img.rows, numlevels);
+	if (layout == CoefLayout::Morton) {
+		MortonLayout morton(img.cols, img.rows);
+		toLayout(img, morton, reordered);
+		coefs = reordered.data();
+		decodeCoefs(morton, steps, minStep);
+		fromLayout(reordered, morton, img);
+	} else {
+		// coefs are addressed by linear index
+		cv::Mat m = img.isContinuous() ? img : img.clone();
+		coefs = m.ptr<int32_t>();
+		decodeCoefs(RowMajorLayout(m.cols, m.rows), steps, minStep);
+		if (m.data != img.data)
+			m.copyTo(img);
+	}
+}
+
+template <class Layout>
+void SpihtDecoder::initialize(const Layout& layout) {
+	// mirrors SpihtEncoder::initialize
+	lip.clear();
+	lsp.clear();
+	lis.clear();
+
+	size_t ox = 0, oy = 0;
+	for (size_t y = 0; y < rootRows; y++) {
+		for (size_t x = 0; x < rootCols; x++) {
+			lip.push_back(layout.index(x, y));
+			if (getOffspring(x, y, ox, oy))
+				lis.push_back(SetItem(layout.index(x, y), SetItem::Type::A));
+		}
+	}
+}
+
+template <class Layout>
+void SpihtDecoder::decodeCoefs(const Layout& layout, int steps, int minStep) {
+	initialize(layout);
+
+	while (steps >= minStep) {
+		size_t numRefined = lsp.size();
+
+		sortingPass(layout, steps);
+
+		refinementPass(steps, numRefined);
+
+		steps--;
+	}
+
+	// lower bitplanes weren't coded, so significant coefs are moved to middle of unknown interval
+	if (minStep > 0) {
+		int32_t half = 1 << (minStep - 1);
+		for (auto i : lsp)
+			coefs[i] += coefs[i] < 0 ? -half : half;
+	}
+}
+
+template <class Layout>
+void SpihtDecoder::sortingPass(const Layout& layout, int step) {
+	// mirrors SpihtEncoder::sortingPass, significance is read instead of computed
+	size_t kept = 0;
+	for (size_t i = 0; i < lip.size(); i++) {
+		auto index = lip[i];
+		if (bitStreamReader->readBit()) {
+			readSignificant(index, step);
+			lsp.push_back(index);
+		} else
+			lip[kept++] = index;
+	}
+	lip.resize(kept);
+
+	size_t ox = 0, oy = 0;
+	kept = 0;
+	for (size_t i = 0; i < lis.size(); i++) {
+		SetItem item = lis[i];
+		if (!bitStreamReader->readBit()) {
+			lis[kept++] = item;
+			continue;
+		}
+
+		getOffspring(layout.x(item.index), layout.y(item.index), ox, oy);
+		if (item.type == SetItem::Type::A) {
+			processOffspring(layout, ox, oy, step);
+			processOffspring(layout, ox + 1, oy, step);
+			processOffspring(layout, ox, oy + 1, step);
+			processOffspring(layout, ox + 1, oy + 1, step);
+
+			size_t gx = 0, gy = 0;
+			if (getOffspring(ox, oy, gx, gy))
+				lis.push_back(SetItem(item.index, SetItem::Type::B));
+		} else {
+			lis.push_back(SetItem(layout.index(ox, oy), SetItem::Type::A));
+			lis.push_back(SetItem(layout.index(ox + 1, oy), SetItem::Type::A));
+			lis.push_back(SetItem(layout.index(ox, oy + 1), SetItem::Type::A));
+			lis.push_back(SetItem(layout.index(ox + 1, oy + 1), SetItem::Type::A));
+		}
+	}
+	lis.resize(kept);
+}
+
+void SpihtDecoder::refinementPass(int step, size_t numRefined) {
+	for (size_t i = 0; i < numRefined; i++) {
+		if (bitStreamReader->readBit()) {
+			auto& coef = coefs[lsp[i]];
+			coef += coef < 0 ? -(1 << step) : (1 << step);
+		}
+	}
+}
+
+template <class Layout>
+void SpihtDecoder::processOffspring(const Layout& layout, size_t x, size_t y, int step) {
+	auto index = layout.index(x, y);
+	if (bitStreamReader->readBit()) {
+		lsp.push_back(index);
+		readSignificant(index, step);
+	} else
+		lip.push_back(index);
+}
+
+void SpihtDecoder::readSignificant(uint32_t index, int step) {
+	// sign bit is set for non-negative coefs
+	coefs[index] = bitStreamReader->readBit() ? (1 << step) : -(1 << step);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file spihtdecoder.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef SPIHT_DECODER_H
+#define SPIHT_DECODER_H
+
+#include "spiht.h"
+#include "bitstream.h"
+#include "coeflayout.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <memory>
+#include <vector>
+
+/**
+ * Set partitioning in hierarchical trees decoder.
+ * @see http://www.cipr.rpi.edu/research/SPIHT/EW_Code/csvt96_sp.pdf
+ */
+class SpihtDecoder : public SpihtCodec
+{
+public:
+	/**
+	 * Constructs new decoder.
+	 * @param bsr stream with encoded bits
+	 */
+	explicit SpihtDecoder(const std::shared_ptr<BitStreamReader>& bsr) : bitStreamReader(bsr), coefs(nullptr) { }
+
+	/**
+	 * Decodes matrix from stream.
+	 * @param numlevels number of dwt levels used while encoding
+	 * @param steps highest bitplane used while encoding
+	 * @param minStep lowest bitplane used while encoding, when it isn't
+	 *     zero coefs are reconstructed to middle of their interval
+	 * @param layout order in which coefs are kept while decoding, it
+	 *     doesn't have to match layout used by encoder
+	 * @retval img decoded matrix, it must be zero initialized
+	 */
+	void decode(int numlevels, int steps, int minStep, cv::Mat& img, CoefLayout layout = CoefLayout::RowMajor);
+private:
+	template <class Layout>
+	void initialize(const Layout& layout);
+
+	template <class Layout>
+	void decodeCoefs(const Layout& layout, int steps, int minStep);
+
+	template <class Layout>
+	void sortingPass(const Layout& layout, int step);
+
+	void refinementPass(int step, size_t numRefined);
+
+	template <class Layout>
+	void processOffspring(const Layout& layout, size_t x, size_t y, int step);
+
+	/// Reads sign of coef that has just got significant and sets its value.
+	void readSignificant(uint32_t index, int step);
+
+	std::shared_ptr<BitStreamReader> bitStreamReader;
+
+	int32_t* coefs;					/// coefs of decoded matrix
+	std::vector<int32_t> reordered;	/// coefs in layout other than row major
+};
+
+#endif // !SPIHT_DECODER_H
@@ -9,157 +9,197 @@
 
 #include "utils.h"
 
+#include <stdexcept>
+#include <algorithm>
+
 int SpihtEncoder::computeMaxSteps(const cv::Mat& m) {
 	// find max of absolute values in m
 	double absmax;
 	cv::minMaxIdx(cv::abs(m), nullptr, &absmax);
 
-	return floor(log(absmax) / log(2.0));
+	int steps = -1;
+	for (auto value = static_cast<int64_t>(absmax); value != 0; value >>= 1)
+		steps++;
+	return steps;
+}
+
+void SpihtEncoder::encode(cv::Mat& img, int numlevels, int steps, int minStep, CoefLayout layout) {
+	if (img.type() != CV_32S)
+		throw std::runtime_error("SpihtEncoder::encode can operate only on 32b integer matrices");
+
+	setSize(img.cols, img.rows, numlevels);
+	if (layout == CoefLayout::Morton) {
+		MortonLayout morton(img.cols, img.rows);
+		toLayout(img, morton, reordered);
+		coefs = reordered.data();
+		encodeCoefs(morton, steps, minStep);
+	} else {
+		// coefs are addressed by linear index
+		cv::Mat m = img.isContinuous() ? img : img.clone();
+		coefs = m.ptr<int32_t>();
+		encodeCoefs(RowMajorLayout(m.cols, m.rows), steps, minStep);
+	}
 }
 
-void SpihtEncoder::initialize(cv::Mat& img, int numlevels) {
+template <class Layout>
+void SpihtEncoder::initialize(const Layout& layout) {
 	// clear lists
 	lip.clear();
 	lsp.clear();
 	lis.clear();
 
-	this->numlevels = numlevels;
-	this->img = &img;
-
 	// add the coordinates in H(highest pyramid level) to the LIP
-	// and only those with descendants also to the LIS as type A
-	for (int y = 0; y < img.rows / (1 << numlevels); y++) {
-		for (int x = 0; x < img.cols / (1 << numlevels); x++) {
-			lip.push_back(cv::Point(x, y));
-			if ((x % 2 != 0) || (y % 2 != 0))
-				lis.push_back(SetItem(x, y, SetItem::Type::A));
+	// and only those with descendants also to the LIS as type A
+	size_t ox = 0, oy = 0;
+	for (size_t y = 0; y < rootRows; y++) {
+		for (size_t x = 0; x < rootCols; x++) {
+			lip.push_back(layout.index(x, y));
+			if (getOffspring(x, y, ox, oy))
+				lis.push_back(SetItem(layout.index(x, y), SetItem::Type::A));
 		}
 	}
+
+	buildDescendantMax(layout);
 }
 
-void SpihtEncoder::encode(cv::Mat& img, int numlevels, int steps) {
-	if (img.type() != CV_32S)
-		throw std::runtime_error("SpihtEncoder::encode can operate only on 32b integer matrices");
+template <class Layout>
+void SpihtEncoder::buildDescendantMax(const Layout& layout) {
+	descendantMax.assign(layout.treeSize(), 0);
+	indirectMax.assign(layout.treeSize(), 0);
+
+	// only coefs in upper left quarter have offspring, and offspring always
+	// follow their parent in row major order, so reverse order visits
+	// offspring first
+	size_t ox = 0, oy = 0;
+	for (size_t y = rows / 2; y-- > 0;) {
+		for (size_t x = cols / 2; x-- > 0;) {
+			if (!getOffspring(x, y, ox, oy))
+				continue;
+
+			int32_t direct = 0, indirect = 0;
+			for (size_t cy = oy; cy < oy + 2; ++cy) {
+				for (size_t cx = ox; cx < ox + 2; ++cx) {
+					direct = std::max(direct, abs(coefs[layout.index(cx, cy)]));
+					if (cx < cols / 2 && cy < rows / 2)
+						indirect = std::max(indirect, descendantMax[layout.treeIndex(cx, cy)]);
+				}
+			}
 
-	initialize(img, numlevels);
+			auto i = layout.treeIndex(x, y);
+			descendantMax[i] = std::max(direct, indirect);
+			indirectMax[i] = indirect;
+		}
+	}
+}
+
+template <class Layout>
+void SpihtEncoder::encodeCoefs(const Layout& layout, int steps, int minStep) {
+	initialize(layout);
 
-	while (steps >= 0) {
+	while (steps >= minStep) {
+		// coefs that get significant in sorting pass aren't refined
+		size_t numRefined = lsp.size();
 
-		sortingPass(steps);
+		sortingPass(layout, steps);
 
-		refinementPass(steps);
+		refinementPass(steps, numRefined);
 
 		// update quantization step
 		steps--;
 	}
 }
 
-void SpihtEncoder::sortingPass(int step) {
-
+template <class Layout>
+void SpihtEncoder::sortingPass(const Layout& layout, int step) {
+	// lists are compacted in place, entries that stay are moved
+	// to front in same order and removed ones are overwritten
+	size_t kept = 0;
 	for (size_t i = 0; i < lip.size(); i++) {
-		bool significant = isPixelSignificant(lip[i], step);
-		bitStreamWriter->writeBit(significant);
-
-		if (significant) {
-			// write sign of current pixel value
-			bitStreamWriter->writeBit(sign(img->at<int32_t>(lip[i])));
+		auto index = lip[i];
+		if (isPixelSignificant(index, step)) {
+			// write significance with sign of current pixel value
+			writeSignificant(coefs[index]);
 
 			// move lip[i] to lsp
-			lsp.push_back(lip[i]);
-			lip.erase(lip.begin() + i);
-			i--;
+			lsp.push_back(index);
+		} else {
+			bitStreamWriter->writeBit(false);
+			lip[kept++] = index;
 		}
 	}
+	lip.resize(kept);
 
+	// sets appended while processing are processed in same pass
+	int32_t threshold = 1 << step;
+	size_t ox = 0, oy = 0;
+	kept = 0;
 	for (size_t i = 0; i < lis.size(); i++) {
+		SetItem item = lis[i];
+		size_t x = layout.x(item.index);
+		size_t y = layout.y(item.index);
+		auto treeIndex = layout.treeIndex(x, y);
+
 		// type A
-		if (lis[i].type == SetItem::Type::A) {
-			bool significant = isDescendantSetSignificant(lis[i].point, step);
+		if (item.type == SetItem::Type::A) {
+			bool significant = descendantMax[treeIndex] >= threshold;
 			bitStreamWriter->writeBit(significant);
 
 			if (significant) {
-				cv::Point off = getOffspring(lis[i].point);
-				processOffspring(off.x, off.y, step);
-				processOffspring(off.x + 1, off.y, step);
-				processOffspring(off.x, off.y + 1, step);
-				processOffspring(off.x + 1, off.y + 1, step);
-
-				// test if L(lis[i].point) is not empty
-				if (getOffspring(off).x != -1)
-					lis.emplace_back(lis[i].point, SetItem::Type::B);
-				lis.erase(lis.begin() + i);
-				i--;
-			}
+				getOffspring(x, y, ox, oy);
+				processOffspring(layout, ox, oy, step);
+				processOffspring(layout, ox + 1, oy, step);
+				processOffspring(layout, ox, oy + 1, step);
+				processOffspring(layout, ox + 1, oy + 1, step);
+
+				// test if L(item) is not empty
+				size_t gx = 0, gy = 0;
+				if (getOffspring(ox, oy, gx, gy))
+					lis.push_back(SetItem(item.index, SetItem::Type::B));
+			} else
+				lis[kept++] = item;
 		// type B
 		} else {
-			bool significant = isIndirectDescendantSetSignificant(lis[i].point, step);
+			bool significant = indirectMax[treeIndex] >= threshold;
 			bitStreamWriter->writeBit(significant);
 
 			if (significant) {
 				// add every offspring to lis as type A
-				cv::Point off = getOffspring(lis[i].point);
-				lis.emplace_back(cv::Point(off.x, off.y), SetItem::Type::A);
-				lis.emplace_back(cv::Point(off.x + 1, off.y), SetItem::Type::A);
-				lis.emplace_back(cv::Point(off.x, off.y + 1), SetItem::Type::A);
-				lis.emplace_back(cv::Point(off.x + 1, off.y + 1), SetItem::Type::A);
-
-				// remove current item from lis
-				lis.erase(lis.begin() + i);
-				i--;
-			}
+				getOffspring(x, y, ox, oy);
+				lis.push_back(SetItem(layout.index(ox, oy), SetItem::Type::A));
+				lis.push_back(SetItem(layout.index(ox + 1, oy), SetItem::Type::A));
+				lis.push_back(SetItem(layout.index(ox, oy + 1), SetItem::Type::A));
+				lis.push_back(SetItem(layout.index(ox + 1, oy + 1), SetItem::Type::A));
+			} else
+				lis[kept++] = item;
 		}
 	}
+	lis.resize(kept);
 }
 
-void SpihtEncoder::refinementPass(int step) {
-	// for each entry in lsp
-	for (size_t i = 0; i < lsp.size(); i++) {
-		auto value = img->at<int32_t>(lsp[i]);
-		// except those included in the last sorting pass
-		if (abs(value) >= (1 << (step + 1))) {
-			// write n-th bit of coefficient
-			bitStreamWriter->writeBit(value & (1 << step));
+void SpihtEncoder::refinementPass(int step, size_t numRefined) {
+	// for each entry in lsp except those included in the last sorting pass
+	// write n-th bit of coefficient, bits are gathered to fields of 32
+	uint32_t field = 0;
+	unsigned fieldBits = 0;
+	for (size_t i = 0; i < numRefined; i++) {
+		field = (field << 1) | ((abs(coefs[lsp[i]]) >> step) & 1);
+		if (++fieldBits == 32) {
+			bitStreamWriter->writeBits(field, 32);
+			field = 0;
+			fieldBits = 0;
 		}
 	}
+	bitStreamWriter->writeBits(field, fieldBits);
 }
 
-void SpihtEncoder::processOffspring(int x, int y, int step) {
-	bool significant = isPixelSignificant(cv::Point(x, y), step);
-	bitStreamWriter->writeBit(significant);
-
-	if (significant) {
-		lsp.emplace_back(x, y);
-		bitStreamWriter->writeBit(sign(img->at<int32_t>(y, x)));
-	} else
-		lip.emplace_back(x, y);
-}
-
-bool SpihtEncoder::isPixelSignificant(const cv::Point& coords, int step) {
-	return abs(img->at<int32_t>(coords)) >= (1 << step);
-}
-
-cv::Point SpihtEncoder::getOffspring(int x, int y) {
-	// get size of highest pyramid level
-	int hx = img->cols / (1 << numlevels);
-	int hy = img->rows / (1 << numlevels);
-
-	cv::Point ret;
-
-	// if we are on highest pyramid level
-	if (x < hx && y < hy) {
-		// pixels in left up corner of 2x2 group doesn't have any offspring
-		ret = cv::Point(x, y);
-		if (x % 2 == 1)
-			ret.x = x + hx - 1;
-		if (y % 2 == 1)
-			ret.y = y + hy - 1;
-		if (ret.x == x && ret.y == y)
-			ret = cv::Point(-1, -1);
+template <class Layout>
+void SpihtEncoder::processOffspring(const Layout& layout, size_t x, size_t y, int step) {
+	auto index = layout.index(x, y);
+	if (isPixelSignificant(index, step)) {
+		lsp.push_back(index);
+		writeSignificant(coefs[index]);
 	} else {
-		ret = cv::Point(2 * x, 2 * y);
-		if (ret.x >= img->cols || ret.y >= img->rows)
-			ret = cv::Point(-1, -1);
+		bitStreamWriter->writeBit(false);
+		lip.push_back(index);
 	}
-
-	return ret;
 }
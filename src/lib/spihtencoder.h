@@ -8,7 +8,10 @@
 #ifndef SPIHT_ENCODER_H
 #define SPIHT_ENCODER_H
 
+#include "spiht.h"
 #include "bitstream.h"
+#include "coeflayout.h"
+#include "utils.h"
 
 #include <opencv2/core/core.hpp>
 
@@ -16,92 +19,74 @@
 #include <vector>
 
 /**
+ * Set partitioning in hierarchical trees encoder.
+ * Unlike EZW it doesn't need entropy coder, all decisions are written
+ * as raw bits. Encoding could be lossy if you pass non-zero minStep
+ * to encode method, bitplanes below it aren't written.
  * @see http://www.cipr.rpi.edu/research/SPIHT/EW_Code/csvt96_sp.pdf
  */
-class SpihtEncoder
+class SpihtEncoder : public SpihtCodec
 {
 public:
-	explicit SpihtEncoder(std::shared_ptr<BitStreamWriter>& bsw) : bitStreamWriter(bsw), numlevels(0), img(nullptr) { }
+	/**
+	 * Constructs new encoder.
+	 * @param bsw stream for encoded bits
+	 */
+	explicit SpihtEncoder(const std::shared_ptr<BitStreamWriter>& bsw) : bitStreamWriter(bsw), coefs(nullptr) { }
 
-	void encode(cv::Mat& img, int numlevels, int steps);
+	/**
+	 * Encodes matrix to stream.
+	 * @param img dwt coefs to be encoded
+	 * @param numlevels number of dwt levels in img
+	 * @param steps highest bitplane, should be from computeMaxSteps call
+	 * @param minStep lowest bitplane that is encoded
+	 * @param layout order in which coefs are kept while encoding, it doesn't change output
+	 */
+	void encode(cv::Mat& img, int numlevels, int steps, int minStep = 0, CoefLayout layout = CoefLayout::RowMajor);
 
-	int computeMaxSteps(const cv::Mat& m);
+	/// Get highest nonzero bitplane of absolute values in m, -1 when m is zero.
+	static int computeMaxSteps(const cv::Mat& m);
 private:
-	struct SetItem
-	{
-		enum class Type { A, B };
+	template <class Layout>
+	void initialize(const Layout& layout);
 
-		cv::Point point;
-		Type type;
+	template <class Layout>
+	void encodeCoefs(const Layout& layout, int steps, int minStep);
 
-		SetItem() { }
-		SetItem(const cv::Point& p, Type type) : point(p), type(type) { }
-		SetItem(int x, int y, Type type) : point(x, y), type(type) { }
-	};
+	template <class Layout>
+	void sortingPass(const Layout& layout, int step);
 
-	void initialize(cv::Mat& img, int numlevels);
+	void refinementPass(int step, size_t numRefined);
 
-	void sortingPass(int step);
+	template <class Layout>
+	void processOffspring(const Layout& layout, size_t x, size_t y, int step);
 
-	void refinementPass(int step);
-
-	void processOffspring(int x, int y, int step);
-
-	/**
-	 * Get first offspring of given pixel.
-	 * You can obtain another 3 offspring by adding 1 to each coordinate.
-	 * @param x pixel x coord
-	 * @param y pixel y coord
-	 * @return first offspring or (-1, -1) when there are no offspring at all.
-	 */
-	cv::Point getOffspring(int x, int y);
-
-	cv::Point getOffspring(const cv::Point& p) {
-		return getOffspring(p.x, p.y);
+	bool isPixelSignificant(uint32_t index, int step) const {
+		return abs(coefs[index]) >= (1 << step);
 	}
 
-	bool isPixelSignificant(const cv::Point& coords, int step);
-
-	template <int StartDepth>
-	bool isSetSignificant(const cv::Point& coords, int step, int depth);
-
-	bool isDescendantSetSignificant(const cv::Point& coords, int step) {
-		return isSetSignificant<1>(coords, step, 0);
+	/// Writes set significance bit followed by sign of coef as single field.
+	void writeSignificant(int32_t coef) {
+		bitStreamWriter->writeBits(sign(coef) ? 3U : 2U, 2);
 	}
 
-	bool isIndirectDescendantSetSignificant(const cv::Point& coords, int step) {
-		return isSetSignificant<2>(coords, step, 0);
-	}
+	/**
+	 * Computes maximal absolute values of descendant sets of all coefs
+	 * with offspring. Maximum doesn't depend on bitplane, so set is
+	 * significant in pass of step when its maximum reaches 2^step and
+	 * every test is single lookup.
+	 */
+	template <class Layout>
+	void buildDescendantMax(const Layout& layout);
 
 	std::shared_ptr<BitStreamWriter> bitStreamWriter;
 
-	std::vector<cv::Point> lsp;		/// list of significant pixels
-	std::vector<cv::Point> lip;		/// list of insignificant pixels
-	std::vector<SetItem> lis;		/// list of insignificant sets
+	int32_t* coefs;					/// coefs of encoded matrix
+	std::vector<int32_t> reordered;	/// coefs in layout other than row major
 
-	int numlevels;
-	cv::Mat* img;
+	// following arrays are indexed by treeIndex of layout
+	std::vector<int32_t> descendantMax;	/// max of set of all descendants (type A)
+	std::vector<int32_t> indirectMax;	/// max of descendants without offspring (type B)
 };
 
-template <int StartDepth>
-bool SpihtEncoder::isSetSignificant(const cv::Point& coords, int step, int depth) {
-	if (depth >= StartDepth && isPixelSignificant(coords, step))
-		return true;
-
-	auto offspring = getOffspring(coords);
-	if (offspring.x == -1 || offspring.y == -1)
-		return false;
-
-	if (isSetSignificant(coords, step, depth + 1))
-		return true;
-	else if (isSetSignificant(cv::Point(coords.x + 1, coords.y), step, depth + 1))
-		return true;
-	else if (isSetSignificant(cv::Point(coords.x, coords.y + 1), step, depth + 1))
-		return true;
-	else if (isSetSignificant(cv::Point(coords.x + 1, coords.y + 1), step, depth + 1))
-		return true;
-
-	return false;
-}
-
 #endif // !SPIHT_ENCODER_H
@@ -0,0 +1,64 @@
+/**
+ * @file tempfile.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "tempfile.h"
+
+#include <vector>
+#include <stdexcept>
+
+std::unique_ptr<TempFile> TempFile::create() {
+	FILE* file = std::tmpfile();
+	if (file == nullptr)
+		return std::unique_ptr<TempFile>();
+
+	return std::unique_ptr<TempFile>(new TempFile(file));
+}
+
+TempFile::TempFile(FILE* file) : file(file), out(this) { }
+
+TempFile::~TempFile() {
+	std::fclose(file);
+}
+
+void TempFile::readAll(const std::function<void (const uint8_t* data, size_t size)>& sink) {
+	if (std::fflush(file) != 0 || std::fseek(file, 0, SEEK_SET) != 0)
+		throw std::runtime_error("Unable to read temporary file!");
+
+	std::vector<uint8_t> block(1 << 16);
+	size_t size;
+	while ((size = std::fread(block.data(), 1, block.size(), file)) != 0)
+		sink(block.data(), size);
+
+	if (std::ferror(file) || std::fseek(file, 0, SEEK_END) != 0)
+		throw std::runtime_error("Unable to read temporary file!");
+}
+
+TempFile::int_type TempFile::overflow(int_type c) {
+	if (traits_type::eq_int_type(c, traits_type::eof()))
+		return traits_type::not_eof(c);
+
+	return std::fputc(c, file) != EOF ? c : traits_type::eof();
+}
+
+std::streamsize TempFile::xsputn(const char* s, std::streamsize n) {
+	return static_cast<std::streamsize>(std::fwrite(s, 1, static_cast<size_t>(n), file));
+}
+
+TempFile::pos_type TempFile::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	if ((which & std::ios_base::out) == 0)
+		return pos_type(off_type(-1));
+
+	int origin = dir == std::ios_base::beg ? SEEK_SET : (dir == std::ios_base::cur ? SEEK_CUR : SEEK_END);
+	if (std::fseek(file, static_cast<long>(off), origin) != 0)
+		return pos_type(off_type(-1));
+
+	return pos_type(off_type(std::ftell(file)));
+}
+
+TempFile::pos_type TempFile::seekpos(pos_type pos, std::ios_base::openmode which) {
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
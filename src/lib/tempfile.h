@@ -0,0 +1,61 @@
+/**
+ * @file tempfile.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef TEMP_FILE_H
+#define TEMP_FILE_H
+
+#include <iostream>
+#include <functional>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Anonymous temporary file, system deletes it when it's closed.
+ * It holds coded data that can't be written to output yet, so they don't
+ * stay in memory. File is written through stl stream, that can seek to
+ * patch data written earlier.
+ */
+class TempFile : private std::streambuf
+{
+public:
+	/**
+	 * Creates temporary file.
+	 * @return null when file can't be created
+	 */
+	static std::unique_ptr<TempFile> create();
+
+	~TempFile();
+
+	/// Get stream that writes to file.
+	std::ostream* stream() {
+		return &out;
+	}
+
+	/**
+	 * Reads whole file from its beginning, stream then continues at end of file.
+	 * @param sink called for every block of data
+	 * @throws std::runtime_error when reading failed
+	 */
+	void readAll(const std::function<void (const uint8_t* data, size_t size)>& sink);
+private:
+	explicit TempFile(FILE* file);
+
+	virtual int_type overflow(int_type c);
+	virtual std::streamsize xsputn(const char* s, std::streamsize n);
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+	virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+	FILE* file;
+	std::ostream out;
+
+	TempFile(const TempFile&);
+	TempFile& operator=(const TempFile&);
+};
+
+#endif // !TEMP_FILE_H
@@ -0,0 +1,115 @@
+/**
+ * @file threadpool.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned numThreads) : stopping(false) {
+	if (numThreads == 0)
+		numThreads = hardwareThreads();
+
+	for (unsigned i = 1; i < numThreads; ++i)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+unsigned ThreadPool::hardwareThreads() {
+	unsigned n = std::thread::hardware_concurrency();
+	return n > 0 ? n : 1;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t chunk, const Task& task) {
+	if (count == 0)
+		return;
+	if (chunk == 0)
+		chunk = 1;
+
+	// nothing to share, run it directly
+	if (workers.empty() || count <= chunk) {
+		task(0, count, 0);
+		return;
+	}
+
+	Job job(task, count, chunk);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job.participants = 1;
+		job.active = 1;
+		jobs.push_back(&job);
+	}
+	jobAvailable.notify_all();
+
+	runJob(job, 0);
+
+	// job lives on our stack, so wait until every thread leaves it
+	std::unique_lock<std::mutex> lock(mutex);
+	jobFinished.wait(lock, [&job] () { return job.active == 0; });
+
+	if (job.error)
+		std::rethrow_exception(job.error);
+}
+
+void ThreadPool::runJob(Job& job, unsigned participant) {
+	std::exception_ptr error;
+
+	for (;;) {
+		size_t index = job.nextChunk++;
+		if (index >= job.numChunks)
+			break;
+
+		if (!job.failed) {
+			size_t begin = index * job.chunk;
+			size_t end = std::min(begin + job.chunk, job.count);
+			try {
+				job.task(begin, end, participant);
+			} catch (...) {
+				error = std::current_exception();
+				job.failed = true;
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// every chunk is claimed now, so job is useless for idle workers
+	auto iter = std::find(jobs.begin(), jobs.end(), &job);
+	if (iter != jobs.end())
+		jobs.erase(iter);
+
+	if (error && !job.error)
+		job.error = error;
+	if (--job.active == 0)
+		jobFinished.notify_all();
+}
+
+void ThreadPool::workerLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		jobAvailable.wait(lock, [this] () { return stopping || !jobs.empty(); });
+		if (stopping)
+			return;
+
+		// join job while holding lock, so job owner can't return before we leave
+		Job* job = jobs.front();
+		unsigned participant = job->participants++;
+		job->active++;
+
+		lock.unlock();
+		runJob(*job, participant);
+		lock.lock();
+	}
+}
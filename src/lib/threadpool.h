@@ -0,0 +1,101 @@
+/**
+ * @file threadpool.h
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstdlib>
+
+/**
+ * Fixed size pool of worker threads for data parallel loops.
+ * Thread calling parallelFor works on the loop too, so pool of size n
+ * has n - 1 worker threads. parallelFor can be called from several threads
+ * at once and also from inside of running loop body.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * Loop body, called with range [begin, end) of loop indices and
+	 * participant index which is lower than size() and unique among
+	 * threads working on same loop, so it can index per thread scratch.
+	 */
+	typedef std::function<void (size_t begin, size_t end, unsigned participant)> Task;
+
+	/**
+	 * Creates pool.
+	 * @param numThreads number of threads that work on loops including
+	 *     calling thread, 0 means number of hardware threads
+	 */
+	explicit ThreadPool(unsigned numThreads = 0);
+
+	~ThreadPool();
+
+	/// Get maximal number of threads working on single loop.
+	unsigned size() const {
+		return static_cast<unsigned>(workers.size()) + 1;
+	}
+
+	/**
+	 * Runs task over range [0, count) split to chunks and waits until
+	 * whole range is processed.
+	 * @param count number of loop indices
+	 * @param chunk number of indices handed to thread at once
+	 * @param task loop body
+	 * @throws anything that task throws, first exception is rethrown after
+	 *     all running chunks finish and rest of range is skipped
+	 */
+	void parallelFor(size_t count, size_t chunk, const Task& task);
+
+	/// Get number of hardware threads, at least 1.
+	static unsigned hardwareThreads();
+private:
+	struct Job
+	{
+		Job(const Task& task, size_t count, size_t chunk) : task(task), count(count), chunk(chunk),
+			numChunks((count + chunk - 1) / chunk), nextChunk(0), participants(0), active(0) {
+			failed = false;
+		}
+
+		const Task& task;
+		size_t count;
+		size_t chunk;
+		size_t numChunks;
+		std::atomic<size_t> nextChunk;
+		std::atomic<bool> failed;		/// set when some chunk threw, rest is skipped
+
+		// following members are guarded by pool mutex
+		unsigned participants;		/// number of threads that joined job so far
+		unsigned active;			/// number of threads currently working on job
+		std::exception_ptr error;
+	};
+
+	void workerLoop();
+
+	/// Works on job until there are no chunks left, job must be joined by caller.
+	void runJob(Job& job, unsigned participant);
+
+	std::vector<std::thread> workers;
+	std::deque<Job*> jobs;			/// jobs that may still have unclaimed chunks
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobFinished;
+	bool stopping;
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif // !THREAD_POOL_H
@@ -116,11 +116,11 @@ public:
 	typedef T* pointer;
 	typedef size_t size_type;
 
-	ConstArrayRef(const pointer ptr, size_type n) : ptr(ptr), n(n) { }
+	ConstArrayRef(const T* ptr, size_type n) : ptr(ptr), n(n) { }
 	ConstArrayRef(const std::vector<T>& vec) : ptr(vec.data()), n(vec.size()) { }
 	ConstArrayRef(ArrayRef<T>& other) : ptr(other.data()), n(other.size()) { }
 
-	const pointer data() const {
+	const T* data() const {
 		return ptr;
 	}
 
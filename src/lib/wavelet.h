@@ -16,6 +16,10 @@ class WaveletBase { protected: WaveletBase() { } };
 
 /**
  * Base class for all wavelets.
+ * Transform methods taking scratch buffer don't modify wavelet object, so
+ * single wavelet can be used from many threads at once when every thread
+ * has its own scratch. Overloads without scratch use buffer owned by wavelet
+ * and aren't thread safe.
  * @tparam T type on which wavelet operates (e.g. float,int etc.)
  */
 template <typename T>
@@ -31,15 +35,110 @@ public:
 	 * @param signal input signal that will be replaced with its dwt. 
 	 *     Its size must be even. First half will contain approx coefs and
 	 *     second half detail coefs.
+	 * @param scratch temp buffer of at least scratchSize(signal.size()) values
 	 */
-	virtual void forward(ArrayRef<T> signal) = 0;
+	virtual void forward(ArrayRef<T> signal, ArrayRef<T> scratch) const = 0;
 
 	/**
 	 * Performs one level in place idwt with this wavelet.
 	 * @param dwt result from forward method that will be replaced with
 	 *     its original if their size is same
+	 * @param scratch temp buffer of at least scratchSize(dwt.size()) values
 	 */
-	virtual void inverse(ArrayRef<T> dwt) = 0;
+	virtual void inverse(ArrayRef<T> dwt, ArrayRef<T> scratch) const = 0;
+
+	/**
+	 * Performs one level in place dwt of strip of neighbouring columns.
+	 * Default implementation gathers every column to scratch and calls
+	 * forward, wavelets should override it with lifting that works
+	 * directly on rows of the strip.
+	 * @param columns pointer to first sample of first column
+	 * @param stride distance between two rows in elements
+	 * @param height number of samples in every column, must be even
+	 * @param width number of columns in strip
+	 * @param scratch temp buffer of at least columnsScratchSize(height, width) values
+	 */
+	virtual void forwardColumns(T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) const {
+		assert(scratch.size() >= columnsScratchSize(height, width));
+
+		ArrayRef<T> column(scratch.data(), height);
+		ArrayRef<T> columnScratch(scratch.data() + height, height);
+		for (size_t x = 0; x < width; ++x) {
+			for (size_t y = 0; y < height; ++y)
+				column[y] = columns[y * stride + x];
+			forward(column, columnScratch);
+			for (size_t y = 0; y < height; ++y)
+				columns[y * stride + x] = column[y];
+		}
+	}
+
+	/**
+	 * Performs one level in place idwt of strip of neighbouring columns.
+	 * @see forwardColumns
+	 */
+	virtual void inverseColumns(T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) const {
+		assert(scratch.size() >= columnsScratchSize(height, width));
+
+		ArrayRef<T> column(scratch.data(), height);
+		ArrayRef<T> columnScratch(scratch.data() + height, height);
+		for (size_t x = 0; x < width; ++x) {
+			for (size_t y = 0; y < height; ++y)
+				column[y] = columns[y * stride + x];
+			inverse(column, columnScratch);
+			for (size_t y = 0; y < height; ++y)
+				columns[y * stride + x] = column[y];
+		}
+	}
+
+	/**
+	 * Get number of lifting steps of this wavelet. Even steps are predicts
+	 * that modify odd samples, odd steps are updates that modify even samples.
+	 */
+	virtual size_t numLiftingSteps() const = 0;
+
+	/**
+	 * Applies one lifting step to whole row of samples, so transforms can
+	 * lift columns line by line.
+	 * @param step index of lifting step in forward order
+	 * @param undo true to undo the step (inverse transform)
+	 * @param rows four neighbour rows, even rows i - 1, i, i + 1, i + 2 for
+	 *     predict of odd row i and odd rows i - 2, i - 1, i, i + 1 for update
+	 *     of even row i, rows outside of signal are extended symmetrically
+	 *     (see liftingMirrorEven and liftingMirrorOdd)
+	 * @param target row that is lifted
+	 * @param width number of samples in each row
+	 */
+	virtual void liftLine(size_t step, bool undo, const T* const* rows, T* target, size_t width) const = 0;
+
+	/**
+	 * Scales lifted even and odd rows to approx and detail coefs.
+	 * @param undo true to scale approx and detail coefs back to lifting domain
+	 */
+	virtual void scaleLines(T* even, T* odd, size_t width, bool undo) const = 0;
+
+	/// Performs one level in place dwt using scratch buffer owned by wavelet.
+	void forward(ArrayRef<T> signal) {
+		tempbank.resize(scratchSize(signal.size()));
+		forward(signal, tempbank);
+	}
+
+	/// Performs one level in place idwt using scratch buffer owned by wavelet.
+	void inverse(ArrayRef<T> dwt) {
+		tempbank.resize(scratchSize(dwt.size()));
+		inverse(dwt, tempbank);
+	}
+
+	/// Get minimal scratch size for forward and inverse of signal with n values.
+	static size_t scratchSize(size_t n) {
+		return n;
+	}
+
+	/// Get minimal scratch size for transforming strip of columns.
+	static size_t columnsScratchSize(size_t height, size_t width) {
+		return height * (width < 2 ? 2 : width);
+	}
+private:
+	std::vector<T> tempbank;		// scratch for overloads without scratch param
 };
 
 #endif // !WAVELET_H
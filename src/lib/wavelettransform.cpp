@@ -9,93 +9,226 @@
 #include <cmath>
 
 #include "wavelettransform.h"
+#include "threadpool.h"
+#include "cdf97wavelet.h"
+#include "cdf53wavelet.h"
+#include "haarwavelet.h"
+#include "int97wavelet.h"
+#include "int137wavelet.h"
+#include "fix97wavelet.h"
 
 #include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
-template <typename T, class Traits>
-WaveletTransformImpl<T, Traits>::WaveletTransformImpl(const std::shared_ptr<wavelet_type>& wavelet, int numLevels) : 
+template <typename T, class Traits, class WaveletType>
+const int WaveletTransformImpl<T, Traits, WaveletType>::COLUMN_STRIP;
+
+template <typename T, class Traits, class WaveletType>
+WaveletTransformImpl<T, Traits, WaveletType>::WaveletTransformImpl(const std::shared_ptr<wavelet_type>& wavelet, int numLevels) : 
 	wavelet(wavelet), numLevels(numLevels) {
 }
 
-template <typename T, class Traits>
-void WaveletTransformImpl<T, Traits>::forward1d(std::vector<value_type>& signal) {
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::forward1d(std::vector<value_type>& signal) {
 	// signal must be 2^numlevels long
 	if (signal.size() % (1 << numLevels) != 0)
 		throw std::runtime_error("WaveletTransform::forward1d: signal must be 2^numLevels long!");
 
+	std::vector<value_type> scratch(wavelet_type::scratchSize(signal.size()));
 	size_t size = signal.size();
 	for (int i = 0; i < numLevels; ++i) {
-		wavelet->forward(ArrayRef<value_type>(signal.data(), size));
+		WaveletCall<WaveletType>::forward(*wavelet, ArrayRef<value_type>(signal.data(), size), scratch);
 		size /= 2;
 	}
 }
 
-template <typename T, class Traits>
-void WaveletTransformImpl<T, Traits>::inverse1d(std::vector<value_type>& dwt) {
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::inverse1d(std::vector<value_type>& dwt) {
 	// input must be 2^numlevels long
 	if (dwt.size() % (1 << numLevels) != 0)
 		throw std::runtime_error("WaveletTransform::inverse1d: input must be 2^numLevels long!");
 
+	std::vector<value_type> scratch(wavelet_type::scratchSize(dwt.size()));
 	// get second highest level size
 	size_t size = dwt.size() / (1 << (numLevels - 1));
 	for (int i = 0; i < numLevels; ++i) {
-		wavelet->inverse(ArrayRef<value_type>(dwt.data(), size));
+		WaveletCall<WaveletType>::inverse(*wavelet, ArrayRef<value_type>(dwt.data(), size), scratch);
 		size *= 2;
 	}
 }
 
-template <typename T, class Traits>
-void WaveletTransformImpl<T, Traits>::forward2d(cv::Mat& signal) {
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::forward2d(cv::Mat& signal) {
 	assert(signal.type() == getType());
 
+	auto scratch = createScratch(signal);
+
 	cv::Mat roi(signal, cv::Rect(0, 0, signal.cols, signal.rows));
 	for (int i = 0; i < numLevels; ++i) {
-		// transform rows
-		for (int i = 0; i < roi.rows; ++i) {
-			ArrayRef<value_type> rowPtr(roi.ptr<value_type>(i), roi.cols);
-			wavelet->forward(rowPtr);
-		}
-		// transform cols by transposing and then transforming by rows
-		cv::Mat transposed = roi.t();
-		for (int i = 0; i < transposed.rows; ++i) {
-			ArrayRef<value_type> rowPtr(transposed.ptr<value_type>(i), transposed.cols);
-			wavelet->forward(rowPtr);
-		}
-		// copy transposed to roi
-		cv::Mat(transposed.t()).copyTo(roi);
+		forwardRows(roi, scratch);
+		forwardColumns(roi, scratch);
 
 		// set roi to upper left corner
 		roi.adjustROI(0, -(roi.rows / 2), 0, -(roi.cols / 2));
 	}
 }
 
-template <typename T, class Traits>
-void WaveletTransformImpl<T, Traits>::inverse2d(cv::Mat& dwt) {
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::inverse2d(cv::Mat& dwt) {
+	inverse2d(dwt, 0);
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::inverse2d(cv::Mat& dwt, int resolutionReduction) {
 	assert(dwt.type() == getType());
+	if (resolutionReduction < 0 || resolutionReduction > numLevels)
+		throw std::runtime_error("WaveletTransform::inverse2d: invalid resolution reduction!");
+
+	auto scratch = createScratch(dwt);
 
 	size_t factor = 1 << (numLevels - 1);
 	cv::Mat roi(dwt, cv::Rect(cv::Point(0, 0), cv::Size(dwt.cols / factor, dwt.rows / factor)));
+	for (int i = 0; i < numLevels - resolutionReduction; ++i) {
+		inverseColumns(roi, scratch);
+		inverseRows(roi, scratch);
+
+		// extend roi
+		roi.adjustROI(0, roi.rows, 0, roi.cols);
+	}
+}
+
+template <typename T, class Traits, class WaveletType>
+cv::Mat WaveletTransformImpl<T, Traits, WaveletType>::inverse2dRegion(const cv::Mat& dwt, const cv::Rect& region) {
+	assert(dwt.type() == getType());
+	if (region.width <= 0 || region.height <= 0 || region.x < 0 || region.y < 0 ||
+		region.x + region.width > dwt.cols || region.y + region.height > dwt.rows)
+		throw std::runtime_error("WaveletTransform::inverse2dRegion: region must be inside of dwt!");
+
+	// every lifting step reads coefs at most 2 positions away, so value
+	// that's margin coefs far from window border isn't affected by wrong
+	// symmetric extension at that border
+	int margin = 2 * static_cast<int>(wavelet->numLiftingSteps()) + 1;
+
+	// windows[i] are coefs of every subband of level i that are needed to
+	// reconstruct window of level i - 1 (or region for level 0)
+	std::vector<cv::Rect> windows(numLevels);
+	cv::Rect needed = region;
 	for (int i = 0; i < numLevels; ++i) {
-		// transform cols by transposing and then transforming by rows
-		cv::Mat transposed = roi.t();
-		for (int i = 0; i < transposed.rows; ++i) {
-			ArrayRef<value_type> rowPtr(transposed.ptr<value_type>(i), transposed.cols);
-			wavelet->inverse(rowPtr);
-		}
-		// copy transposed to roi
-		cv::Mat(transposed.t()).copyTo(roi);
+		int halfCols = dwt.cols >> (i + 1), halfRows = dwt.rows >> (i + 1);
+		int x0 = std::max(0, needed.x / 2 - margin);
+		int y0 = std::max(0, needed.y / 2 - margin);
+		int x1 = std::min(halfCols, (needed.x + needed.width + 1) / 2 + margin);
+		int y1 = std::min(halfRows, (needed.y + needed.height + 1) / 2 + margin);
+		windows[i] = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+		needed = windows[i];
+	}
 
-		// transform rows
-		for (int i = 0; i < roi.rows; ++i) {
-			ArrayRef<value_type> rowPtr(roi.ptr<value_type>(i), roi.cols);
-			wavelet->inverse(rowPtr);
+	cv::Mat approx = numLevels > 0 ? dwt(windows[numLevels - 1]) : dwt(region);
+	for (int i = numLevels - 1; i >= 0; --i) {
+		const cv::Rect& w = windows[i];
+		int halfCols = dwt.cols >> (i + 1), halfRows = dwt.rows >> (i + 1);
+
+		// gather windows of all four subbands to small dwt of one level
+		cv::Mat local(2 * w.height, 2 * w.width, getType());
+		for (int band = 0; band < 4; ++band) {
+			int bandX = band % 2, bandY = band / 2;
+			cv::Mat dest(local, cv::Rect(bandX * w.width, bandY * w.height, w.width, w.height));
+			if (band == 0)
+				approx.copyTo(dest);
+			else
+				dwt(cv::Rect(w.x + bandX * halfCols, w.y + bandY * halfRows, w.width, w.height)).copyTo(dest);
 		}
 
-		// extend roi
-		roi.adjustROI(0, roi.rows, 0, roi.cols);
+		auto scratch = createScratch(local);
+		inverseColumns(local, scratch);
+		inverseRows(local, scratch);
+
+		// local now holds samples [2 * w.x, 2 * (w.x + w.width)) x [2 * w.y, ...)
+		// and only those far enough from borders inside of image are valid
+		const cv::Rect& next = i > 0 ? windows[i - 1] : region;
+		approx = local(cv::Rect(next.x - 2 * w.x, next.y - 2 * w.y, next.width, next.height));
+	}
+
+	return approx.clone();
+}
+
+template <typename T, class Traits, class WaveletType>
+double WaveletTransformImpl<T, Traits, WaveletType>::lowpassGain() {
+	// constant signal isn't changed by symmetric extension, so its approx
+	// coef is exactly dc gain of 1d lowpass
+	const value_type level = 256;
+	std::vector<value_type> signal(2, level);
+	std::vector<value_type> scratch(wavelet_type::scratchSize(signal.size()));
+	WaveletCall<WaveletType>::forward(*wavelet, signal, scratch);
+
+	double gain = static_cast<double>(signal[0]) / level;
+	return gain * gain;
+}
+
+template <typename T, class Traits, class WaveletType>
+typename WaveletTransformImpl<T, Traits, WaveletType>::ScratchBanks WaveletTransformImpl<T, Traits, WaveletType>::createScratch(const cv::Mat& m) {
+	size_t size = std::max(wavelet_type::scratchSize(m.cols), wavelet_type::columnsScratchSize(m.rows, COLUMN_STRIP));
+	unsigned numThreads = pool ? pool->size() : 1;
+	return ScratchBanks(numThreads, std::vector<value_type>(size));
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::parallelFor(size_t count, const LoopBody& body) {
+	if (!pool) {
+		body(0, count, 0);
+		return;
 	}
+
+	// few chunks per thread, so threads that finish early can help others
+	size_t chunk = std::max<size_t>(1, count / (4 * pool->size()));
+	pool->parallelFor(count, chunk, body);
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::forwardRows(cv::Mat& roi, ScratchBanks& scratch) {
+	parallelFor(roi.rows, [&] (size_t begin, size_t end, unsigned participant) {
+		for (size_t y = begin; y < end; ++y) {
+			ArrayRef<value_type> rowPtr(roi.ptr<value_type>(static_cast<int>(y)), roi.cols);
+			WaveletCall<WaveletType>::forward(*wavelet, rowPtr, scratch[participant]);
+		}
+	});
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::inverseRows(cv::Mat& roi, ScratchBanks& scratch) {
+	parallelFor(roi.rows, [&] (size_t begin, size_t end, unsigned participant) {
+		for (size_t y = begin; y < end; ++y) {
+			ArrayRef<value_type> rowPtr(roi.ptr<value_type>(static_cast<int>(y)), roi.cols);
+			WaveletCall<WaveletType>::inverse(*wavelet, rowPtr, scratch[participant]);
+		}
+	});
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::forwardColumns(cv::Mat& roi, ScratchBanks& scratch) {
+	// columns are transformed in place in strips of neighbouring columns,
+	// lifting then works on whole cache lines instead of single values
+	size_t numStrips = (roi.cols + COLUMN_STRIP - 1) / COLUMN_STRIP;
+	parallelFor(numStrips, [&] (size_t begin, size_t end, unsigned participant) {
+		for (size_t strip = begin; strip < end; ++strip) {
+			int x = static_cast<int>(strip) * COLUMN_STRIP;
+			int width = std::min(COLUMN_STRIP, roi.cols - x);
+			WaveletCall<WaveletType>::forwardColumns(*wavelet, roi.ptr<value_type>(0) + x, roi.step1(), roi.rows, width, scratch[participant]);
+		}
+	});
+}
+
+template <typename T, class Traits, class WaveletType>
+void WaveletTransformImpl<T, Traits, WaveletType>::inverseColumns(cv::Mat& roi, ScratchBanks& scratch) {
+	size_t numStrips = (roi.cols + COLUMN_STRIP - 1) / COLUMN_STRIP;
+	parallelFor(numStrips, [&] (size_t begin, size_t end, unsigned participant) {
+		for (size_t strip = begin; strip < end; ++strip) {
+			int x = static_cast<int>(strip) * COLUMN_STRIP;
+			int width = std::min(COLUMN_STRIP, roi.cols - x);
+			WaveletCall<WaveletType>::inverseColumns(*wavelet, roi.ptr<value_type>(0) + x, roi.step1(), roi.rows, width, scratch[participant]);
+		}
+	});
 }
 
 // this is explicit template instantiation
@@ -103,4 +236,10 @@ void WaveletTransformImpl<T, Traits>::inverse2d(cv::Mat& dwt) {
 // instantiation of WaveletTransformImpl with other types than those
 // listed here will fail on horrible linked errors!
 template class WaveletTransformImpl<int32_t>;
-template class WaveletTransformImpl<float>;
\ No newline at end of file
+template class WaveletTransformImpl<float>;
+template class WaveletTransformImpl<float, WaveletTransformTraits<float>, Cdf97Wavelet>;
+template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Cdf53Wavelet>;
+template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, HaarWavelet>;
+template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Int97Wavelet>;
+template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Int137Wavelet>;
+template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Fix97Wavelet>;
\ No newline at end of file
@@ -15,6 +15,16 @@
 #include <utility>
 #include <memory>
 #include <list>
+#include <vector>
+#include <functional>
+
+class ThreadPool;
+class Cdf97Wavelet;
+class Cdf53Wavelet;
+class HaarWavelet;
+class Int97Wavelet;
+class Int137Wavelet;
+class Fix97Wavelet;
 
 /**
  * Wavelet transform interface
@@ -32,6 +42,36 @@ public:
 
 	/// Computes inverse 2d dwt
 	virtual void inverse2d(cv::Mat& dwt) = 0;
+
+	/**
+	 * Computes inverse 2d dwt, that stops given number of levels early.
+	 * Reconstructed approx band is then in upper left corner of dwt and
+	 * it's dwt.size() / 2^resolutionReduction big. Its values are scaled by
+	 * lowpassGain()^resolutionReduction.
+	 * @param resolutionReduction number of finest levels that aren't inverted
+	 */
+	virtual void inverse2d(cv::Mat& dwt, int resolutionReduction) = 0;
+
+	/**
+	 * Reconstructs only given region of signal. Every level inverts just the
+	 * window of coefs that lies within filter support of region, so cost
+	 * depends on region size and not on size of whole dwt.
+	 * @param dwt coefs of whole signal, they aren't changed
+	 * @param region part of signal to reconstruct
+	 * @return reconstructed region, same as region of inverse2d(dwt)
+	 * @throws std::runtime_error when region isn't inside of dwt
+	 */
+	virtual cv::Mat inverse2dRegion(const cv::Mat& dwt, const cv::Rect& region) = 0;
+
+	/// Get dc gain of 2d lowpass filter of one level.
+	virtual double lowpassGain() = 0;
+
+	/**
+	 * Sets pool that splits rows and column strips of 2d transforms between threads.
+	 * Pool can be shared with other transforms. Without pool transforms run
+	 * on calling thread only.
+	 */
+	virtual void setThreadPool(const std::shared_ptr<ThreadPool>& pool) = 0;
 };
 
 template <typename T>
@@ -52,18 +92,67 @@ struct WaveletTransformTraits<int32_t>
 	static const int cvMatType = CV_32S;
 };
 
+/**
+ * Calls wavelet methods from transform loops. When W is concrete wavelet
+ * calls are qualified, so they are bound statically and can be inlined.
+ * For Wavelet<T> itself they are ordinary virtual calls.
+ */
+template <class W>
+struct WaveletCall
+{
+	typedef typename W::impl_type T;
+
+	static void forward(const W& w, ArrayRef<T> signal, ArrayRef<T> scratch) {
+		w.W::forward(signal, scratch);
+	}
+
+	static void inverse(const W& w, ArrayRef<T> dwt, ArrayRef<T> scratch) {
+		w.W::inverse(dwt, scratch);
+	}
+
+	static void forwardColumns(const W& w, T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) {
+		w.W::forwardColumns(columns, stride, height, width, scratch);
+	}
+
+	static void inverseColumns(const W& w, T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) {
+		w.W::inverseColumns(columns, stride, height, width, scratch);
+	}
+};
+
+template <typename T>
+struct WaveletCall<Wavelet<T>>
+{
+	static void forward(const Wavelet<T>& w, ArrayRef<T> signal, ArrayRef<T> scratch) {
+		w.forward(signal, scratch);
+	}
+
+	static void inverse(const Wavelet<T>& w, ArrayRef<T> dwt, ArrayRef<T> scratch) {
+		w.inverse(dwt, scratch);
+	}
+
+	static void forwardColumns(const Wavelet<T>& w, T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) {
+		w.forwardColumns(columns, stride, height, width, scratch);
+	}
+
+	static void inverseColumns(const Wavelet<T>& w, T* columns, size_t stride, size_t height, size_t width, ArrayRef<T> scratch) {
+		w.inverseColumns(columns, stride, height, width, scratch);
+	}
+};
+
 /**
  * Wavelet transform implementation.
  * @tparam T type on which transform operates (currently only float and int32_t allowed)
  * @tparam Traits traits type for some specific type related values
+ * @tparam WaveletType wavelet class, when it's concrete wavelet instead of
+ *     Wavelet<T> row and column loops call it without virtual dispatch
  */
-template <typename T, class Traits = WaveletTransformTraits<T>>
+template <typename T, class Traits = WaveletTransformTraits<T>, class WaveletType = Wavelet<T>>
 class WaveletTransformImpl : public WaveletTransform
 {
 public:
 	typedef Traits traits_type;
 	typedef T value_type;
-	typedef Wavelet<value_type> wavelet_type;
+	typedef WaveletType wavelet_type;
 
 	WaveletTransformImpl(const std::shared_ptr<wavelet_type>& wavelet, int numLevels);
 
@@ -78,9 +167,38 @@ public:
 	virtual void forward2d(cv::Mat& signal);
 
 	virtual void inverse2d(cv::Mat& dwt);
+
+	virtual void inverse2d(cv::Mat& dwt, int resolutionReduction);
+
+	virtual cv::Mat inverse2dRegion(const cv::Mat& dwt, const cv::Rect& region);
+
+	virtual double lowpassGain();
+
+	virtual void setThreadPool(const std::shared_ptr<ThreadPool>& pool) {
+		this->pool = pool;
+	}
 private:
+	/// number of neighbouring columns transformed at once, 16 values of
+	/// float or int32_t fill whole 64 byte cache line
+	static const int COLUMN_STRIP = 16;
+
+	typedef std::vector<std::vector<value_type>> ScratchBanks;
+	typedef std::function<void (size_t, size_t, unsigned)> LoopBody;
+
+	/// Allocates scratch for every thread that can work on transform of m.
+	ScratchBanks createScratch(const cv::Mat& m);
+
+	/// Runs body over [0, count) on pool or on calling thread when there's no pool.
+	void parallelFor(size_t count, const LoopBody& body);
+
+	void forwardRows(cv::Mat& roi, ScratchBanks& scratch);
+	void inverseRows(cv::Mat& roi, ScratchBanks& scratch);
+	void forwardColumns(cv::Mat& roi, ScratchBanks& scratch);
+	void inverseColumns(cv::Mat& roi, ScratchBanks& scratch);
+
 	std::shared_ptr<wavelet_type> wavelet;
 	int numLevels;
+	std::shared_ptr<ThreadPool> pool;
 };
 
 // Extern template instantiation, actual instantiation is done in 
@@ -89,6 +207,46 @@ private:
 // listed here will fail on horrible linked errors!
 extern template class WaveletTransformImpl<int32_t>;
 extern template class WaveletTransformImpl<float>;
+extern template class WaveletTransformImpl<float, WaveletTransformTraits<float>, Cdf97Wavelet>;
+extern template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Cdf53Wavelet>;
+extern template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, HaarWavelet>;
+extern template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Int97Wavelet>;
+extern template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Int137Wavelet>;
+extern template class WaveletTransformImpl<int32_t, WaveletTransformTraits<int32_t>, Fix97Wavelet>;
+
+/**
+ * Selects transform implementation for wavelet type. Built-in wavelets get
+ * statically dispatched transform, other wavelets are called virtually.
+ */
+template <class WaveletType>
+struct WaveletTransformSelector
+{
+	typedef WaveletTransformImpl<typename WaveletType::impl_type> type;
+};
+
+template <class WaveletType, typename T>
+struct StaticWaveletTransformSelector
+{
+	typedef WaveletTransformImpl<T, WaveletTransformTraits<T>, WaveletType> type;
+};
+
+template <>
+struct WaveletTransformSelector<Cdf97Wavelet> : StaticWaveletTransformSelector<Cdf97Wavelet, float> { };
+
+template <>
+struct WaveletTransformSelector<Cdf53Wavelet> : StaticWaveletTransformSelector<Cdf53Wavelet, int32_t> { };
+
+template <>
+struct WaveletTransformSelector<HaarWavelet> : StaticWaveletTransformSelector<HaarWavelet, int32_t> { };
+
+template <>
+struct WaveletTransformSelector<Int97Wavelet> : StaticWaveletTransformSelector<Int97Wavelet, int32_t> { };
+
+template <>
+struct WaveletTransformSelector<Int137Wavelet> : StaticWaveletTransformSelector<Int137Wavelet, int32_t> { };
+
+template <>
+struct WaveletTransformSelector<Fix97Wavelet> : StaticWaveletTransformSelector<Fix97Wavelet, int32_t> { };
 
 /**
  * Factory for wavelet transform that creates right WaveletTransform object for given wavelet.
@@ -108,7 +266,7 @@ public:
 		const std::shared_ptr<WaveletType>& wavelet, 
 		int numlevels) {
 		
-		return new WaveletTransformImpl<typename WaveletType::impl_type>(wavelet, numlevels);
+		return new typename WaveletTransformSelector<WaveletType>::type(wavelet, numlevels);
 	}
 
 	/**
@@ -121,7 +279,7 @@ public:
 	 */
 	template <typename WaveletType>
 	static typename std::enable_if<std::is_base_of<WaveletBase, WaveletType>::value, WaveletTransform>::type* create(int numlevels) {
-		return new WaveletTransformImpl<typename WaveletType::impl_type>(std::make_shared<WaveletType>(), numlevels);
+		return new typename WaveletTransformSelector<WaveletType>::type(std::make_shared<WaveletType>(), numlevels);
 	}
 };
 
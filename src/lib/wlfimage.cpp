@@ -8,80 +8,222 @@
 #include "wlfimage.h"
 
 #include "wavelettransform.h"
+#include "linewavelettransform.h"
 #include "cdf97wavelet.h"
 #include "cdf53wavelet.h"
+#include "haarwavelet.h"
+#include "int97wavelet.h"
+#include "int137wavelet.h"
+#include "fix97wavelet.h"
 #include "ezwencoder.h"
 #include "ezwdecoder.h"
+#include "spihtencoder.h"
+#include "spihtdecoder.h"
+#include "threadpool.h"
+#include "boundedqueue.h"
+#include "mappedfile.h"
+#include "tempfile.h"
+#include "colorplanes.h"
+#include "utils.h"
 
 #include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
 
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <map>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
-void WlfImage::PixelFormat::transformFrom(Type type, const cv::Mat& src, cv::Mat& dest) {
-	using namespace std::placeholders;
-	static std::function<void (const cv::Mat&, cv::Mat&)> colorTransforms[] = {
-		std::bind(cv::cvtColor, _1, _2, CV_RGB2BGR, 0), std::bind(cv::cvtColor, _1, _2, CV_GRAY2BGR, 0),
-		std::bind(cv::cvtColor, _1, _2, CV_YCrCb2BGR, 0), std::bind(cv::cvtColor, _1, _2, CV_YCrCb2BGR, 0)
-	};
-
-	colorTransforms[static_cast<int>(type)](src, dest);
+/**
+ * Get pool with given number of threads. Pools are created on first use and
+ * shared by all later saves and reads, so threads aren't started for every
+ * image. Pool can run loops of several images at once.
+ */
+static std::shared_ptr<ThreadPool> sharedThreadPool(unsigned numThreads) {
+	if (numThreads == 0)
+		numThreads = ThreadPool::hardwareThreads();
+
+	// single thread doesn't need pool at all
+	if (numThreads == 1)
+		return std::shared_ptr<ThreadPool>();
+
+	static std::mutex poolsMutex;
+	static std::map<unsigned, std::shared_ptr<ThreadPool>> pools;
+	std::lock_guard<std::mutex> lock(poolsMutex);
+	auto& pool = pools[numThreads];
+	if (!pool)
+		pool = std::make_shared<ThreadPool>(numThreads);
+	return pool;
 }
 
-void WlfImage::PixelFormat::transformTo(Type type, const cv::Mat& src, cv::Mat& dest) {
-	using namespace std::placeholders;
-	static std::function<void (const cv::Mat&, cv::Mat&)> colorTransforms[] = {
-		std::bind(cv::cvtColor, _1, _2, CV_BGR2RGB, 0), std::bind(cv::cvtColor, _1, _2, CV_BGR2GRAY, 0),
-		std::bind(cv::cvtColor, _1, _2, CV_BGR2YCrCb, 0), std::bind(cv::cvtColor, _1, _2, CV_BGR2YCrCb, 0)
-	};
+static std::unique_ptr<WaveletTransform> createWaveletTransform(WlfImage::WaveletType type, int numlevels,
+	const std::shared_ptr<ThreadPool>& pool) {
 
-	colorTransforms[static_cast<int>(type)](src, dest);
-}
-
-static std::unique_ptr<WaveletTransform> createWaveletTransform(WlfImage::WaveletType type, int numlevels) {
+	std::unique_ptr<WaveletTransform> wt;
 	switch (type)
 	{
 	case WlfImage::WaveletType::Cdf97:
-		return std::unique_ptr<WaveletTransform>(WaveletTransformFactory::create<Cdf97Wavelet>(numlevels));
+		wt.reset(WaveletTransformFactory::create<Cdf97Wavelet>(numlevels));
+		break;
 	case WlfImage::WaveletType::Cdf53:
-		return std::unique_ptr<WaveletTransform>(WaveletTransformFactory::create<Cdf53Wavelet>(numlevels));
+		wt.reset(WaveletTransformFactory::create<Cdf53Wavelet>(numlevels));
+		break;
+	case WlfImage::WaveletType::Haar:
+		wt.reset(WaveletTransformFactory::create<HaarWavelet>(numlevels));
+		break;
+	case WlfImage::WaveletType::Int97:
+		wt.reset(WaveletTransformFactory::create<Int97Wavelet>(numlevels));
+		break;
+	case WlfImage::WaveletType::Int137:
+		wt.reset(WaveletTransformFactory::create<Int137Wavelet>(numlevels));
+		break;
+	case WlfImage::WaveletType::Fix97:
+		wt.reset(WaveletTransformFactory::create<Fix97Wavelet>(numlevels));
+		break;
 	default:
 		throw std::runtime_error("Unknown wavelet");
 	}
+
+	wt->setThreadPool(pool);
+	return wt;
 }
 
+/**
+ * Runs body for every index lower than count, indices are spread over pool
+ * threads when there's pool. It's used for tiles and for channels of tile.
+ */
+static void forEachIndex(const std::shared_ptr<ThreadPool>& pool, size_t count, const std::function<void (size_t)>& body) {
+	if (!pool) {
+		for (size_t i = 0; i < count; ++i)
+			body(i);
+		return;
+	}
+
+	pool->parallelFor(count, 1, [&] (size_t begin, size_t end, unsigned) {
+		for (size_t i = begin; i < end; ++i)
+			body(i);
+	});
+}
+
+static int numChannels(WlfImage::PixelFormat::Type pf) {
+	return pf == WlfImage::PixelFormat::Type::Gray ? 1 : 3;
+}
+
+/// highest bitplane of 32bit coefs
+static const int32_t MAX_BITPLANE = 31;
+
+/// highest spiht bitplane, spiht coders compute thresholds 1 << step in int
+static const int32_t MAX_SPIHT_BITPLANE = 30;
+
+/// Get layout of coefs for zerotree coders, see preferredLayout.
+static CoefLayout coefLayout(const cv::Mat& m) {
+	return preferredLayout(m.cols, m.rows);
+}
+
+/**
+ * File header.
+ * Version 1 files have width right after magic and store channels of whole
+ * image coded by EZW with arithmetic coder. Version 2 writes zero there,
+ * which isn't valid width, followed by version number. Its header adds tile
+ * size, entropy coder and coder of EZW dominant pass and it's followed by
+ * table of tile offsets. Tiles are coded independently.
+ */
 struct Header
 {
 	static const char* MAGIC;
 	static const size_t MAGIC_LEN = 8;
+	static const uint8_t VERSION = 2;	/// version written by ImageWriter
 
+	uint8_t version;
 	uint32_t width;
 	uint32_t height;
 	WlfImage::PixelFormat::Type pf;
 	uint8_t dwtLevels;
 	WlfImage::WaveletType waveletType;
 	uint16_t quantStep;
+	uint32_t tileWidth;		/// size of tiles, tiles at right and bottom border may be smaller
+	uint32_t tileHeight;
+	WlfImage::EntropyCoder coder;
+	WlfImage::SymbolCoder symbolCoder;
+
+	size_t tilesPerRow() const {
+		return (width + tileWidth - 1) / tileWidth;
+	}
+
+	size_t numTiles() const {
+		return tilesPerRow() * ((height + tileHeight - 1) / tileHeight);
+	}
+
+	/// Get rectangle of image covered by tile, tiles are stored in row major order.
+	cv::Rect tile(size_t index) const {
+		int x = static_cast<int>(index % tilesPerRow() * tileWidth);
+		int y = static_cast<int>(index / tilesPerRow() * tileHeight);
+		return cv::Rect(x, y, std::min<int>(tileWidth, width - x), std::min<int>(tileHeight, height - y));
+	}
 };
 
 const char* Header::MAGIC = "\x89\x57\x4c\x46\x0d\x0a\x1a\x0a";
 
+/**
+ * Writer of wlf data to file or to memory.
+ * Coded passes are written to output while they're encoded, sizes that
+ * precede them are reserved and patched when passes are finished. Data
+ * that have to wait for data before them are spilled to temporary file,
+ * so they don't take memory.
+ */
 class ImageWriter
 {
 public:
-	explicit ImageWriter(const char* file) : ofile(file, std::ios_base::binary) {
+	explicit ImageWriter(const char* file) : ofile(file, std::ios_base::binary), out(&ofile), buffer(nullptr) {
 		if (!ofile)
 			throw std::runtime_error("Unable to open file\"" + std::string(file) + "\" for writing!");
 	}
 
+	/// Creates writer that appends to buffer.
+	explicit ImageWriter(std::vector<uint8_t>* buffer) : out(nullptr), buffer(buffer) { }
+
+	/**
+	 * Creates writer of data that can't go to output of this writer yet.
+	 * Writer to file spills them to temporary file, writer to memory or
+	 * writer without temporary file keeps them in memory.
+	 */
+	std::unique_ptr<ImageWriter> createSpill() const {
+		std::unique_ptr<TempFile> temp;
+		if (out != nullptr)
+			temp = TempFile::create();
+		return std::unique_ptr<ImageWriter>(new ImageWriter(std::move(temp)));
+	}
+
+	/// Appends all data written by spill writer.
+	void writeSpill(ImageWriter& spill) {
+		if (spill.temp)
+			spill.temp->readAll([this] (const uint8_t* data, size_t size) { writeBytes(data, size); });
+		else
+			writeBuffer(spill.spilled);
+	}
+
+	/// Get position where next data will be written.
+	uint64_t position() {
+		return out != nullptr ? static_cast<uint64_t>(out->tellp()) : buffer->size();
+	}
+
 	void writeHeader(const Header& header) {
+		assert(header.version == Header::VERSION);
+
 		// write magic sequence
-		ofile.write(Header::MAGIC, Header::MAGIC_LEN);
+		writeBytes(Header::MAGIC, Header::MAGIC_LEN);
+
+		// zero width marks versioned header
+		writeElement(static_cast<uint32_t>(0));
+		writeElement(header.version);
 
 		writeElement(header.width);
 		writeElement(header.height);
@@ -89,9 +231,33 @@ public:
 		writeElement(header.dwtLevels);
 		writeElement(header.waveletType);
 		writeElement(header.quantStep);
+		writeElement(header.tileWidth);
+		writeElement(header.tileHeight);
+		writeElement(header.coder);
+		writeElement(header.symbolCoder);
 	}
 
-	void writeChannel(cv::Mat& channel, size_t compressRate) {
+	/**
+	 * Writes offsets of tiles relative to end of table.
+	 * @param offsets numTiles + 1 offsets, last one is end of last tile
+	 */
+	void writeTileOffsets(const std::vector<uint64_t>& offsets) {
+		for (auto offset : offsets)
+			writeElement(offset);
+	}
+
+	/// Overwrites table of tile offsets that was written at tablePosition.
+	void patchTileOffsets(uint64_t tablePosition, const std::vector<uint64_t>& offsets) {
+		for (size_t i = 0; i < offsets.size(); ++i)
+			writeElementAt(tablePosition + i * sizeof(uint64_t), offsets[i]);
+	}
+
+	/// Writes data of tile or channel that were encoded by another writer.
+	void writeEncoded(const std::vector<uint8_t>& data) {
+		writeBuffer(data);
+	}
+
+	void writeChannel(cv::Mat& channel, size_t compressRate, WlfImage::SymbolCoder symbolCoder) {
 		assert(channel.type() == CV_32S);
 
 		auto threshold = EzwEncoder::computeInitTreshold(channel);
@@ -100,33 +266,112 @@ public:
 		int32_t minTreshold = compressRate != 0 ? 1 << (compressRate - 1) : 0;
 		writeElement(minTreshold);
 
-		// create separate streams for dominant and subordinant ezw passes
-		std::ostringstream dominantSS, subordSS;
-		auto dominantBS = std::make_shared<BitStreamWriter>(&dominantSS);
-		auto subordBS = std::make_shared<BitStreamWriter>(&subordSS);
-		auto ae = std::make_shared<ArithmeticEncoder>(dominantBS);
+		// sizes of passes are patched when passes are written
+		auto sizesPosition = position();
+		writeElement(static_cast<size_t>(0));
+		writeElement(static_cast<size_t>(0));
+
+		// dominant pass goes straight to output, subordinate pass follows
+		// it in file, so it's spilled until dominant pass is finished
+		auto subord = createSpill();
+		auto subordBS = subord->createBitStreamWriter();
+		auto dominantStart = position();
+
+		// ezw encode, encoder closes coder of dominant pass
+		if (symbolCoder == WlfImage::SymbolCoder::Range) {
+			auto re = out != nullptr ? std::make_shared<RangeEncoder>(out) : std::make_shared<RangeEncoder>(buffer);
+			auto ezwEncoder = EzwEncoder(re, subordBS);
+			ezwEncoder.encode(channel, threshold, minTreshold, coefLayout(channel));
+		} else {
+			auto ae = std::make_shared<ArithmeticEncoder>(createBitStreamWriter());
+			auto ezwEncoder = EzwEncoder(ae, subordBS);
+			ezwEncoder.encode(channel, threshold, minTreshold, coefLayout(channel));
+		}
+
+		auto dominantSize = static_cast<size_t>(position() - dominantStart);
+		writeElementAt(sizesPosition, dominantSize);
+		writeElementAt(sizesPosition + sizeof(size_t), static_cast<size_t>(subord->position()));
+		writeSpill(*subord);
+	}
+
+	void writeSpihtChannel(cv::Mat& channel, int dwtLevels, size_t compressRate) {
+		assert(channel.type() == CV_32S);
+
+		// bitplanes lower than compress rate aren't encoded, same as in ezw
+		int32_t minStep = static_cast<int32_t>(compressRate);
+
+		// channel with less bitplanes codes empty ones down to minStep, so reader can reject steps lower than minStep
+		int32_t steps = std::max(SpihtEncoder::computeMaxSteps(channel), minStep);
+		writeElement(steps);
+		writeElement(minStep);
 
-		// ezw encode
-		auto ezwEncoder = EzwEncoder(ae, subordBS);
-		ezwEncoder.encode(channel, threshold, minTreshold);
+		// size is patched when channel is written
+		auto sizePosition = position();
+		writeElement(static_cast<size_t>(0));
 
-		// write passes to file
-		auto dominantEncoded = dominantSS.str();
-		auto subordEncoded = subordSS.str();
-		writeElement(dominantEncoded.size());
-		writeElement(subordEncoded.size());
-		ofile.write(dominantEncoded.data(), dominantEncoded.size());
-		ofile.write(subordEncoded.data(), subordEncoded.size());
+		auto start = position();
+		auto bs = createBitStreamWriter();
+		SpihtEncoder spihtEncoder(bs);
+		spihtEncoder.encode(channel, dwtLevels, steps, minStep, coefLayout(channel));
+		bs->flush();
+
+		writeElementAt(sizePosition, static_cast<size_t>(position() - start));
 	}
 private:
+	/// Creates spill writer, it writes to memory when there's no temporary file.
+	explicit ImageWriter(std::unique_ptr<TempFile> temp) : out(nullptr), buffer(&spilled), temp(std::move(temp)) {
+		if (this->temp)
+			out = this->temp->stream();
+	}
+
+	std::shared_ptr<BitStreamWriter> createBitStreamWriter() {
+		return out != nullptr ? std::make_shared<BitStreamWriter>(out) : std::make_shared<BitStreamWriter>(buffer);
+	}
+
 	template <typename T>
 	void writeElement(const T& elm) {
-		ofile.write(reinterpret_cast<const char*>(&elm), sizeof(elm));
-		if (!ofile)
-			throw std::runtime_error("Unable to write element to stream");
+		writeBytes(&elm, sizeof(elm));
+	}
+
+	/// Overwrites element that was already written at pos.
+	template <typename T>
+	void writeElementAt(uint64_t pos, const T& elm) {
+		if (out == nullptr) {
+			assert(pos + sizeof(elm) <= buffer->size());
+			memcpy(buffer->data() + pos, &elm, sizeof(elm));
+			return;
+		}
+
+		auto end = out->tellp();
+		out->seekp(static_cast<std::streamoff>(pos));
+		writeElement(elm);
+		out->seekp(end);
+	}
+
+	void writeBuffer(const std::vector<uint8_t>& data) {
+		writeBytes(data.data(), data.size());
+	}
+
+	void writeBytes(const void* data, size_t size) {
+		auto bytes = static_cast<const uint8_t*>(data);
+		if (out == nullptr) {
+			buffer->insert(buffer->end(), bytes, bytes + size);
+			return;
+		}
+
+		out->write(reinterpret_cast<const char*>(bytes), size);
+		if (!*out)
+			throw std::runtime_error("Unable to write to stream");
 	}
 
 	std::ofstream ofile;
+	std::ostream* out;				/// stream of file, null when writing to memory
+	std::vector<uint8_t>* buffer;	/// memory where data are appended
+	std::unique_ptr<TempFile> temp;	/// temporary file of spill writer
+	std::vector<uint8_t> spilled;	/// memory of spill writer without temporary file
+
+	ImageWriter(const ImageWriter&);
+	ImageWriter& operator=(const ImageWriter&);
 };
 
 template <typename T>
@@ -134,95 +379,271 @@ int signum(T val) {
 	return (T(0) < val) - (val < T(0));
 }
 
-static cv::Mat scalarQuantize(const cv::Mat& m, int step) {
-	cv::Mat result(m.size(), CV_32S);
-	if (m.type() == CV_32F) {
-		for (int y = 0; y < m.rows; ++y) {
-			for (int x = 0; x < m.cols; ++x) {
-				float val = m.at<float>(y, x);
-				result.at<int32_t>(y, x) = static_cast<int32_t>(signum(val) * floor(abs(val) / step + 0.5));
-			}
-		}
-	} else if (m.type() == CV_32S) {
-		for (int y = 0; y < m.rows; ++y) {
-			for (int x = 0; x < m.cols; ++x) {
-				int32_t val = m.at<int32_t>(y, x);
-				result.at<int32_t>(y, x) = static_cast<int32_t>(signum(val) * floor(abs(val) / step + 0.5));
-			}
-		}
-	} else
-		throw std::runtime_error("scalarQuantize: invalid matrix type");
+/// Quantizes coef by scalar quantization with given step.
+static inline int32_t quantize(float val, int step) {
+	return static_cast<int32_t>(signum(val) * floor(abs(val) / step + 0.5));
+}
+
+static inline int32_t quantize(int32_t val, int step) {
+	// rounded in integers, float pipeline rounds same way
+	return signum(val) * ((abs(val) + step / 2) / step);
+}
 
-	return result;
+/**
+ * Computes quantized dwt of one channel of tile by line based transform.
+ * Rows of tile are split to planes of pixel format one by one and coefs
+ * are quantized as soon as they are final, so channel is never held in
+ * wavelet type as whole. Every level buffers only rows its lifting steps need.
+ * @param cols width of channel
+ */
+template <class WaveletType>
+static cv::Mat transformChannel(const cv::Mat& tile, const WlfImage::Params& params, size_t channel, int cols) {
+	typedef typename WaveletType::impl_type value_type;
+
+	int step = params.quantizationStep;
+	cv::Mat coefs(tile.rows, cols, CV_32S);
+	LineWaveletTransform<value_type> lwt(std::make_shared<WaveletType>(), params.dwtLevels, cols, tile.rows);
+	lwt.beginForward([&] (size_t y, size_t x, const value_type* values, size_t count) {
+		int32_t* row = coefs.ptr<int32_t>(static_cast<int>(y)) + x;
+		for (size_t i = 0; i < count; ++i)
+			row[i] = quantize(values[i], step);
+	});
+
+	std::vector<cv::Mat> planes;
+	for (int y = 0; y < tile.rows; ++y) {
+		splitToPlanes(params.pf, tile.row(y), WaveletTransformTraits<value_type>::cvMatType, planes);
+		lwt.pushRow(planes[channel].ptr<value_type>());
+	}
+
+	return coefs;
+}
+
+static cv::Mat transformChannel(const cv::Mat& tile, const WlfImage::Params& params, size_t channel) {
+	int cols = channel > 0 && params.pf == WlfImage::PixelFormat::Type::YCbCr422 ? tile.cols / 2 : tile.cols;
+	switch (params.waveletType)
+	{
+	case WlfImage::WaveletType::Cdf97:
+		return transformChannel<Cdf97Wavelet>(tile, params, channel, cols);
+	case WlfImage::WaveletType::Cdf53:
+		return transformChannel<Cdf53Wavelet>(tile, params, channel, cols);
+	case WlfImage::WaveletType::Haar:
+		return transformChannel<HaarWavelet>(tile, params, channel, cols);
+	case WlfImage::WaveletType::Int97:
+		return transformChannel<Int97Wavelet>(tile, params, channel, cols);
+	case WlfImage::WaveletType::Int137:
+		return transformChannel<Int137Wavelet>(tile, params, channel, cols);
+	case WlfImage::WaveletType::Fix97:
+		return transformChannel<Fix97Wavelet>(tile, params, channel, cols);
+	default:
+		throw std::runtime_error("Unknown wavelet");
+	}
+}
+
+static void encodeTile(const cv::Mat& tile, const WlfImage::Params& params, const std::shared_ptr<ThreadPool>& pool,
+	ImageWriter& writer) {
+
+	// every channel is transformed from rows of tile, color transform and
+	// chroma subsampling are done per row, so they're repeated for every channel
+	size_t count = static_cast<size_t>(numChannels(params.pf));
+	auto encodeChannel = [&] (size_t channel, ImageWriter& channelWriter) {
+		auto quantized = transformChannel(tile, params, channel);
+		if (params.entropyCoder == WlfImage::EntropyCoder::Spiht)
+			channelWriter.writeSpihtChannel(quantized, params.dwtLevels, params.compressRate);
+		else
+			channelWriter.writeChannel(quantized, params.compressRate, params.symbolCoder);
+	};
+
+	// without pool channels go straight to writer
+	if (!pool) {
+		for (size_t i = 0; i < count; ++i)
+			encodeChannel(i, writer);
+		return;
+	}
+
+	// channels are independent, so they're encoded in parallel, first one goes straight
+	// to writer and others are spilled and written after it in order
+	std::vector<std::unique_ptr<ImageWriter>> spills(count);
+	for (size_t i = 1; i < count; ++i)
+		spills[i] = writer.createSpill();
+	forEachIndex(pool, count, [&] (size_t i) {
+		encodeChannel(i, i == 0 ? writer : *spills[i]);
+	});
+	for (size_t i = 1; i < count; ++i)
+		writer.writeSpill(*spills[i]);
 }
 
 void WlfImage::save(const char* file, const cv::Mat& img, const Params& params /* = Params */) {
 	// open file
 	ImageWriter writer(file);
 
-	// write header
-	Header header = { img.cols, img.rows, params.pf, params.dwtLevels, params.waveletType, params.quantizationStep };
-	writer.writeHeader(header);
+	// image without tiles is stored as one big tile
+	bool tiled = params.tileSize.area() > 0;
+	Header header = { Header::VERSION, img.cols, img.rows, params.pf, params.dwtLevels, params.waveletType,
+		params.quantizationStep, tiled ? params.tileSize.width : img.cols, tiled ? params.tileSize.height : img.rows,
+		params.entropyCoder, params.symbolCoder };
 
-	// transform input from bgr to desired color model
-	cv::Mat colorTransformed;
-	PixelFormat::transformTo(params.pf, img, colorTransformed);
+	int32_t maxBitplane = params.entropyCoder == EntropyCoder::Spiht ? MAX_SPIHT_BITPLANE : MAX_BITPLANE;
+	if (params.compressRate > static_cast<size_t>(maxBitplane))
+		throw std::runtime_error("Compress rate is greater than number of bitplanes!");
 
-	// dwt with specified levels
-	auto wt = createWaveletTransform(params.waveletType, params.dwtLevels);
+	// every tile must be divisible by 2^dwtLevels, subsampled chroma of tile too,
+	// image without tiles is checked same way
+	int factor = 1 << params.dwtLevels;
+	int widthFactor = params.pf == PixelFormat::Type::YCbCr422 ? 2 * factor : factor;
+	if (header.tileWidth % widthFactor != 0 || header.width % widthFactor != 0 ||
+		header.tileHeight % factor != 0 || header.height % factor != 0)
+		throw std::runtime_error("Tile size and image size must be divisible by 2^dwtLevels!");
 
-	// convert input to wavelet type
-	cv::Mat image;
-	colorTransformed.convertTo(image, wt->getType());
+	// write header
+	writer.writeHeader(header);
 
-	// split image channels
-	std::vector<cv::Mat> channels;
-	cv::split(image, channels);
-	assert(channels.size() == 3);
+	// tiles are split to planes of pixel format from 8bit bgr, decoded images have 8bit pixels anyway
+	cv::Mat image = img;
+	if (img.depth() != CV_8U)
+		img.convertTo(image, CV_8U);
 
-	// chromatic subsampling
-	if (params.pf == PixelFormat::Type::YCbCr422) {
-		cv::Mat cb = channels[1].clone();
-		cv::resize(cb, channels[1], cv::Size(), 0.5, 1.0, cv::INTER_NEAREST);
+	auto pool = sharedThreadPool(params.numThreads);
 
-		cv::Mat cr = channels[2].clone();
-		cv::resize(cr, channels[2], cv::Size(), 0.5, 1.0, cv::INTER_NEAREST);
-	}
+	// single tile is encoded straight to file, its size is patched in offset table
+	if (header.numTiles() == 1) {
+		std::vector<uint64_t> offsets(2, 0);
+		auto tablePosition = writer.position();
+		writer.writeTileOffsets(offsets);
 
-	// dwt channels and write it
-	for (auto& channel : channels) {
-		wt->forward2d(channel);
-		auto quantized = scalarQuantize(channel, params.quantizationStep);
-		writer.writeChannel(quantized, params.compressRate);
+		auto tileStart = writer.position();
+		encodeTile(image, params, pool, writer);
+		offsets[1] = writer.position() - tileStart;
+		writer.patchTileOffsets(tablePosition, offsets);
+		return;
 	}
+
+	// tiles are independent, so they're encoded in parallel to memory and written in order
+	std::vector<std::vector<uint8_t>> tiles(header.numTiles());
+	forEachIndex(pool, tiles.size(), [&] (size_t i) {
+		ImageWriter tileWriter(&tiles[i]);
+		encodeTile(image(header.tile(i)), params, pool, tileWriter);
+	});
+
+	std::vector<uint64_t> offsets(1, 0);
+	for (auto& tile : tiles)
+		offsets.push_back(offsets.back() + tile.size());
+	writer.writeTileOffsets(offsets);
+	for (auto& tile : tiles)
+		writer.writeEncoded(tile);
 }
 
+/**
+ * Reader of wlf data in memory.
+ * Coded passes are decoded in place, so data of mapped file or caller
+ * buffer aren't copied at all.
+ */
 class ImageReader
 {
 public:
-	ImageReader(const char* file) : ifile(file, std::ios_base::binary) {
-		if (!ifile)
-			throw std::runtime_error("Unable to open file\"" + std::string(file) + "\" for reading!");
-	}
+	/// Creates reader of buffer, it has to live as long as reader.
+	explicit ImageReader(ConstArrayRef<uint8_t> data) : data(data), position(0), tilesStart(0) { }
 
 	Header readHeader() {
-		char magicBuff[Header::MAGIC_LEN + 1] = {0};	// +1 for trailing zero
-		ifile.read(magicBuff, Header::MAGIC_LEN);
-		if (std::string(Header::MAGIC) != magicBuff)
+		if (data.size() < Header::MAGIC_LEN || memcmp(data.data(), Header::MAGIC, Header::MAGIC_LEN) != 0)
 			throw std::runtime_error("Invalid magic number!");
+		position = Header::MAGIC_LEN;
 
 		Header header;
 		readElement(header.width);
+		if (header.width == 0) {
+			readElement(header.version);
+			if (header.version != Header::VERSION)
+				throw std::runtime_error("Unsupported file version!");
+			readElement(header.width);
+		} else
+			header.version = 1;
+
 		readElement(header.height);
 		readElement(header.pf);
 		readElement(header.dwtLevels);
 		readElement(header.waveletType);
 		readElement(header.quantStep);
 
+		if (header.version >= 2) {
+			readElement(header.tileWidth);
+			readElement(header.tileHeight);
+			if (header.tileWidth == 0 || header.tileHeight == 0)
+				throw std::runtime_error("Invalid tile size!");
+
+			readElement(header.coder);
+			if (header.coder != WlfImage::EntropyCoder::Ezw && header.coder != WlfImage::EntropyCoder::Spiht)
+				throw std::runtime_error("Unknown entropy coder!");
+
+			readElement(header.symbolCoder);
+			if (header.symbolCoder != WlfImage::SymbolCoder::Arithmetic && header.symbolCoder != WlfImage::SymbolCoder::Range)
+				throw std::runtime_error("Unknown symbol coder!");
+		} else {
+			header.tileWidth = header.width;
+			header.tileHeight = header.height;
+			header.coder = WlfImage::EntropyCoder::Ezw;
+			header.symbolCoder = WlfImage::SymbolCoder::Arithmetic;
+		}
+
 		return header;
 	}
 
-	cv::Mat readChannel(size_t width, size_t height) {
+	/**
+	 * Reads tile offset table, must be called right after readHeader.
+	 * Version 1 file has single tile that spans to end of file.
+	 */
+	std::vector<uint64_t> readTileOffsets(const Header& header) {
+		std::vector<uint64_t> offsets(header.version >= 2 ? header.numTiles() + 1 : 2);
+		if (header.version >= 2) {
+			for (auto& offset : offsets)
+				readElement(offset);
+			tilesStart = position;
+		} else {
+			tilesStart = position;
+			offsets[1] = data.size() - tilesStart;
+		}
+
+		return offsets;
+	}
+
+	/// Get encoded data of tile, so it can be decoded by another reader.
+	ConstArrayRef<uint8_t> readTile(const std::vector<uint64_t>& offsets, size_t index) {
+		assert(index + 1 < offsets.size());
+		if (offsets[index + 1] < offsets[index])
+			throw std::runtime_error("Invalid tile offsets!");
+		if (offsets[index + 1] > data.size() - tilesStart)
+			throw std::runtime_error("Unable to read tile from stream");
+
+		return ConstArrayRef<uint8_t>(data.data() + tilesStart + offsets[index],
+			static_cast<size_t>(offsets[index + 1] - offsets[index]));
+	}
+
+	/**
+	 * Finds data of all channels of tile, so they can be decoded in parallel
+	 * by another readers. File doesn't have table of channels, channels are
+	 * found by skipping coded passes, whose sizes are in channel headers.
+	 */
+	std::vector<ConstArrayRef<uint8_t>> readChannelTable(size_t numChannels, WlfImage::EntropyCoder coder) {
+		std::vector<ConstArrayRef<uint8_t>> table;
+		for (size_t i = 0; i < numChannels; ++i) {
+			size_t start = position;
+			int32_t threshold, minThreshold;
+			readElement(threshold);
+			readElement(minThreshold);
+
+			// ezw channel has dominant and subordinate pass, spiht channel single one
+			size_t size, subordSize = 0;
+			readElement(size);
+			if (coder == WlfImage::EntropyCoder::Ezw)
+				readElement(subordSize);
+			readBuffer(size);
+			readBuffer(subordSize);
+
+			table.push_back(ConstArrayRef<uint8_t>(data.data() + start, position - start));
+		}
+		return table;
+	}
+
+	cv::Mat readChannel(size_t width, size_t height, WlfImage::SymbolCoder symbolCoder) {
 		int32_t threshold;
 		readElement(threshold);
 		int32_t minTreshold;
@@ -232,81 +653,296 @@ public:
 		readElement(dominantSize);
 		readElement(subordSize);
 
-		std::unique_ptr<char[]> dominantPass(new char[dominantSize]);
-		std::unique_ptr<char[]> subordPass(new char[subordSize]);
-		ifile.read(dominantPass.get(), dominantSize);
-		ifile.read(subordPass.get(), subordSize);
+		auto dominantPass = readBuffer(dominantSize);
+		auto subordPass = readBuffer(subordSize);
 
-		std::istringstream dominantSS(std::string(dominantPass.get(), dominantSize));
-		std::istringstream subordSS(std::string(subordPass.get(), subordSize));
-		auto dominantBS = std::make_shared<BitStreamReader>(&dominantSS);
-		auto subordBS = std::make_shared<BitStreamReader>(&subordSS);
-		auto ad = std::make_shared<ArithmeticDecoder>(dominantBS);
+		// readers decode passes in place, bits past end of pass are read as zeros
+		auto zeroFill = BitStreamReader::EndPolicy::ZeroFill;
+		auto dominantBS = std::make_shared<BitStreamReader>(dominantPass.data(), dominantPass.size(), zeroFill);
+		auto subordBS = std::make_shared<BitStreamReader>(subordPass.data(), subordPass.size(), zeroFill);
 
 		cv::Mat result = cv::Mat::zeros(height, width, CV_32S);
-		auto ezwDecoder = EzwDecoder(ad, subordBS);
-		ezwDecoder.decode(threshold, minTreshold, result);
+		if (symbolCoder == WlfImage::SymbolCoder::Range) {
+			auto rd = std::make_shared<RangeDecoder>(dominantPass.data(), dominantPass.size());
+			auto ezwDecoder = EzwDecoder(rd, subordBS);
+			ezwDecoder.decode(threshold, minTreshold, result, coefLayout(result));
+		} else {
+			auto ad = std::make_shared<ArithmeticDecoder>(dominantBS);
+			auto ezwDecoder = EzwDecoder(ad, subordBS);
+			ezwDecoder.decode(threshold, minTreshold, result, coefLayout(result));
+		}
 
 		return result;
 
 	}
+
+	cv::Mat readSpihtChannel(size_t width, size_t height, int dwtLevels) {
+		int32_t steps, minStep;
+		readElement(steps);
+		readElement(minStep);
+		if (minStep < 0 || steps > MAX_SPIHT_BITPLANE || minStep > steps)
+			throw std::runtime_error("Invalid spiht bitplanes!");
+
+		size_t size;
+		readElement(size);
+
+		auto encoded = readBuffer(size);
+		auto bs = std::make_shared<BitStreamReader>(encoded.data(), encoded.size(), BitStreamReader::EndPolicy::ZeroFill);
+
+		cv::Mat result = cv::Mat::zeros(height, width, CV_32S);
+		SpihtDecoder spihtDecoder(bs);
+		spihtDecoder.decode(dwtLevels, steps, minStep, result, coefLayout(result));
+
+		return result;
+	}
 private:
 	template <typename T>
 	void readElement(T& elm) {
-		ifile.read(reinterpret_cast<char*>(&elm), sizeof(elm));
-		if (!ifile)
+		if (data.size() - position < sizeof(elm))
 			throw std::runtime_error("Unable to read element from stream");
+		memcpy(&elm, data.data() + position, sizeof(elm));
+		position += sizeof(elm);
+	}
+
+	/// Get next size bytes of coded data.
+	ConstArrayRef<uint8_t> readBuffer(size_t size) {
+		if (data.size() - position < size)
+			throw std::runtime_error("Unable to read channel from stream");
+		ConstArrayRef<uint8_t> buffer(data.data() + position, size);
+		position += size;
+		return buffer;
 	}
 
-	std::ifstream ifile;
+	ConstArrayRef<uint8_t> data;
+	size_t position;			/// position of next element in data
+	size_t tilesStart;			/// position of first tile
 };
 
 static cv::Mat dequantize(const cv::Mat& m, int step) {
+	if (step == 1)
+		return m;
+
 	return m.mul(cv::Scalar::all(step));
 }
 
-cv::Mat WlfImage::read(const char* file) {
-	ImageReader reader(file);
-	Header header = reader.readHeader();
+/**
+ * Decodes one channel of tile and converts it to wavelet type.
+ * Returned channel is still in dwt domain.
+ */
+static cv::Mat decodeChannel(ConstArrayRef<uint8_t> data, size_t index, const Header& header, const cv::Size& tileSize,
+	WaveletTransform& wt) {
+
+	ImageReader reader(data);
+	size_t width = tileSize.width, height = tileSize.height;
+	// when colors where subsampled we must adjust current channel size
+	if (header.pf == WlfImage::PixelFormat::Type::YCbCr422 && index > 0)
+		width /= 2;
+
+	// read channel and dequantize
+	auto channel = dequantize(header.coder == WlfImage::EntropyCoder::Spiht ?
+		reader.readSpihtChannel(width, height, header.dwtLevels) :
+		reader.readChannel(width, height, header.symbolCoder), header.quantStep);
+
+	// convert channel to wavelet type, integer wavelets use it as is
+	if (channel.type() == wt.getType())
+		return channel;
+
+	cv::Mat converted;
+	channel.convertTo(converted, wt.getType());
+	return converted;
+}
+
+/// Channel of tile that is entropy decoded and waits for reconstruction.
+struct DecodedChannel
+{
+	size_t tile;
+	size_t index;
+	cv::Mat coefs;
+};
+
+/**
+ * Decodes channels of all tiles in pipeline. Entropy decoding runs in own
+ * thread and hands channels over bounded queue to pool threads, that
+ * reconstruct them while next channels are decoded. finishTile is called
+ * once all channels of tile were reconstructed. Without pool every channel
+ * is decoded and reconstructed before next one.
+ */
+static void decodeTiles(const std::vector<ConstArrayRef<uint8_t>>& tiles, const std::vector<cv::Rect>& tileRects,
+	const Header& header, WaveletTransform& wt, const std::shared_ptr<ThreadPool>& pool,
+	const std::function<void (size_t tile, size_t channel, cv::Mat& coefs)>& reconstruct,
+	const std::function<void (size_t tile)>& finishTile) {
+
+	// channels are located first, so every one can be decoded alone
+	size_t channelsPerTile = numChannels(header.pf);
+	std::vector<std::vector<ConstArrayRef<uint8_t>>> channelData;
+	for (auto& tile : tiles) {
+		ImageReader reader(tile);
+		channelData.push_back(reader.readChannelTable(channelsPerTile, header.coder));
+	}
+
+	if (!pool) {
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			for (size_t i = 0; i < channelsPerTile; ++i) {
+				auto coefs = decodeChannel(channelData[t][i], i, header, tileRects[t].size(), wt);
+				reconstruct(t, i, coefs);
+			}
+			finishTile(t);
+		}
+		return;
+	}
 
-	// read channels
-	int numChannels = header.pf == PixelFormat::Type::Gray ? 1 : 3;
-	std::vector<cv::Mat> channels(numChannels);
-	auto wt = createWaveletTransform(header.waveletType, header.dwtLevels);
-	for (int i = 0; i < numChannels; ++i) {
-		size_t width = header.width, height = header.height;
-		// when colors where subsampled we must adjust current channel size
-		if (header.pf == PixelFormat::Type::YCbCr422 && i > 0)
-			width /= 2;
+	// queue holds channel per thread, so decoder can't get far ahead and decoded coefs don't pile up
+	BoundedQueue<DecodedChannel> queue(pool->size());
+	std::exception_ptr decodeError;
+	std::thread decoder([&] () {
+		try {
+			forEachIndex(pool, tiles.size() * channelsPerTile, [&] (size_t item) {
+				DecodedChannel channel;
+				channel.tile = item / channelsPerTile;
+				channel.index = item % channelsPerTile;
+				channel.coefs = decodeChannel(channelData[channel.tile][channel.index], channel.index, header,
+					tileRects[channel.tile].size(), wt);
+				// queue is closed when reconstruction failed, rest of channels is skipped then
+				if (!queue.push(std::move(channel)))
+					throw std::runtime_error("Decoding was cancelled!");
+			});
+		} catch (...) {
+			decodeError = std::current_exception();
+		}
+		queue.close();
+	});
+
+	std::vector<size_t> remaining(tiles.size(), channelsPerTile);
+	std::mutex remainingMutex;
+	try {
+		pool->parallelFor(pool->size(), 1, [&] (size_t, size_t, unsigned) {
+			try {
+				DecodedChannel channel;
+				while (queue.pop(channel)) {
+					reconstruct(channel.tile, channel.index, channel.coefs);
+
+					bool last;
+					{
+						std::lock_guard<std::mutex> lock(remainingMutex);
+						last = --remaining[channel.tile] == 0;
+					}
+					if (last)
+						finishTile(channel.tile);
+				}
+			} catch (...) {
+				queue.close();
+				throw;
+			}
+		});
+	} catch (...) {
+		decoder.join();
+		throw;
+	}
 
-		// read channel and dequantize
-		auto channel = dequantize(reader.readChannel(width, height), header.quantStep);
+	decoder.join();
+	if (decodeError)
+		std::rethrow_exception(decodeError);
+}
 
-		// convert channel to wavelet type and perform idwt
-		cv::Mat convertedChannel;
-		channel.convertTo(convertedChannel, wt->getType());
-		wt->inverse2d(convertedChannel);
+cv::Mat WlfImage::read(const char* file, int resolutionReduction /* = 0 */, unsigned numThreads /* = 0 */) {
+	MappedFile mapped(file);
+	return read(mapped.data(), mapped.size(), resolutionReduction, numThreads);
+}
 
-		// convert result to final 8bit
-		convertedChannel.convertTo(channels[i], CV_8U);
+cv::Mat WlfImage::read(const uint8_t* data, size_t size, int resolutionReduction /* = 0 */, unsigned numThreads /* = 0 */) {
+	ImageReader reader(ConstArrayRef<uint8_t>(data, size));
+	Header header = reader.readHeader();
+	if (resolutionReduction < 0 || resolutionReduction > header.dwtLevels)
+		throw std::runtime_error("Resolution reduction is greater than number of dwt levels!");
+
+	// locate all tiles, decoding then runs in parallel
+	auto offsets = reader.readTileOffsets(header);
+	std::vector<ConstArrayRef<uint8_t>> tiles;
+	std::vector<cv::Rect> tileRects;
+	for (size_t i = 0; i < header.numTiles(); ++i) {
+		tiles.push_back(reader.readTile(offsets, i));
+		tileRects.push_back(header.tile(i));
 	}
 
-	// Chromatic subsampling
-	if (header.pf == PixelFormat::Type::YCbCr422) {
-		cv::Mat cb = channels[1].clone();
-		cv::resize(cb, channels[1], cv::Size(), 2.0, 1.0, cv::INTER_NEAREST);
+	auto pool = sharedThreadPool(numThreads);
+	auto wt = createWaveletTransform(header.waveletType, header.dwtLevels, pool);
+	double scale = std::pow(wt->lowpassGain(), -resolutionReduction);
+
+	cv::Mat image(header.height >> resolutionReduction, header.width >> resolutionReduction, CV_8UC3);
+
+	// reconstructed channels wait for rest of tile, then colors of tile are converted while next tiles are decoded
+	std::vector<std::vector<cv::Mat>> planes(tiles.size(), std::vector<cv::Mat>(numChannels(header.pf)));
+	decodeTiles(tiles, tileRects, header, *wt, pool, [&] (size_t t, size_t i, cv::Mat& channel) {
+		wt->inverse2d(channel, resolutionReduction);
 
-		cv::Mat cr = channels[2].clone();
-		cv::resize(cr, channels[2], cv::Size(), 2.0, 1.0, cv::INTER_NEAREST);
+		// approx band of skipped levels is scaled back when it's converted to 8bits
+		planes[t][i] = channel(cv::Rect(0, 0, channel.cols >> resolutionReduction, channel.rows >> resolutionReduction));
+	}, [&] (size_t t) {
+		const cv::Rect& tile = tileRects[t];
+		cv::Mat destRoi(image, cv::Rect(tile.x >> resolutionReduction, tile.y >> resolutionReduction,
+			tile.width >> resolutionReduction, tile.height >> resolutionReduction));
+
+		// conversion to 8bits, chromatic upsampling and color transform in one pass
+		mergeFromPlanes(header.pf, planes[t], scale, 0, destRoi);
+		planes[t].clear();
+	});
+
+	return image;
+}
+
+cv::Mat WlfImage::readRegion(const char* file, const cv::Rect& region, unsigned numThreads /* = 0 */) {
+	MappedFile mapped(file);
+	return readRegion(mapped.data(), mapped.size(), region, numThreads);
+}
+
+cv::Mat WlfImage::readRegion(const uint8_t* data, size_t size, const cv::Rect& region, unsigned numThreads /* = 0 */) {
+	ImageReader reader(ConstArrayRef<uint8_t>(data, size));
+	Header header = reader.readHeader();
+	if (region.width <= 0 || region.height <= 0 || region.x < 0 || region.y < 0 ||
+		region.x + region.width > static_cast<int>(header.width) || region.y + region.height > static_cast<int>(header.height))
+		throw std::runtime_error("Region must be inside of image!");
+
+	// only tiles that overlap region are read and decoded
+	auto offsets = reader.readTileOffsets(header);
+	std::vector<ConstArrayRef<uint8_t>> tiles;
+	std::vector<cv::Rect> tileRects;
+	for (size_t i = 0; i < header.numTiles(); ++i) {
+		if ((header.tile(i) & region).area() > 0) {
+			tiles.push_back(reader.readTile(offsets, i));
+			tileRects.push_back(header.tile(i));
+		}
 	}
 
-	// merge channels to one image
-	cv::Mat image;
-	cv::merge(channels, image);
+	auto pool = sharedThreadPool(numThreads);
+	auto wt = createWaveletTransform(header.waveletType, header.dwtLevels, pool);
 
-	// transform color from image color model to bgr
-	cv::Mat colorTransformed = image;
-	PixelFormat::transformFrom(header.pf, image, colorTransformed);
+	cv::Mat image(region.height, region.width, CV_8UC3);
+
+	// part of tile inside of region
+	auto partInTile = [&] (size_t t) {
+		const cv::Rect& tile = tileRects[t];
+		cv::Rect part = tile & region;
+		return cv::Rect(part.x - tile.x, part.y - tile.y, part.width, part.height);
+	};
 
-	return colorTransformed;
+	std::vector<std::vector<cv::Mat>> planes(tiles.size(), std::vector<cv::Mat>(numChannels(header.pf)));
+	decodeTiles(tiles, tileRects, header, *wt, pool, [&] (size_t t, size_t i, cv::Mat& channel) {
+		cv::Rect inTile = partInTile(t);
+		// subsampled chroma channels cover part by half as many columns
+		cv::Rect chromaInTile(inTile.x / 2, inTile.y, (inTile.x + inTile.width + 1) / 2 - inTile.x / 2, inTile.height);
+
+		// whole tile had to be entropy decoded, only idwt is limited to region
+		bool subsampled = header.pf == PixelFormat::Type::YCbCr422 && i > 0;
+		planes[t][i] = wt->inverse2dRegion(channel, subsampled ? chromaInTile : inTile);
+	}, [&] (size_t t) {
+		cv::Rect inTile = partInTile(t);
+		cv::Mat destRoi(image, cv::Rect(tileRects[t].x + inTile.x - region.x, tileRects[t].y + inTile.y - region.y,
+			inTile.width, inTile.height));
+
+		// odd part starts in middle of chroma sample
+		mergeFromPlanes(header.pf, planes[t], 1.0, inTile.x - 2 * (inTile.x / 2), destRoi);
+		planes[t].clear();
+	});
+
+	return image;
 }
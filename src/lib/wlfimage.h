@@ -19,7 +19,13 @@ class WlfImage
 {
 public:
 	/// Wavelets that can be used
-	enum class WaveletType : uint8_t { Cdf97, Cdf53 };
+	enum class WaveletType : uint8_t { Cdf97, Cdf53, Haar, Int97, Int137, Fix97 };
+
+	/// Coders of quantized dwt coefs
+	enum class EntropyCoder : uint8_t { Ezw, Spiht };
+
+	/// Coders of ezw dominant pass symbols
+	enum class SymbolCoder : uint8_t { Arithmetic, Range };
 
 	/// Format of pixel
 	struct PixelFormat
@@ -28,38 +34,79 @@ public:
 		enum class Type : uint8_t {
 			RGB, Gray, YCbCr444, YCbCr422
 		};
-
-		static void transformTo(Type, const cv::Mat&, cv::Mat&);
-		static void transformFrom(Type, const cv::Mat&, cv::Mat&);
 	};
 
 	/// Wlf format parameters
 	struct Params
 	{
 		Params() : pf(PixelFormat::Type::YCbCr444), dwtLevels(2),
-			compressRate(0), quantizationStep(1), waveletType(WlfImage::WaveletType::Cdf97) { }
+			compressRate(0), quantizationStep(1), waveletType(WlfImage::WaveletType::Cdf97), numThreads(0),
+			tileSize(0, 0), entropyCoder(EntropyCoder::Ezw), symbolCoder(SymbolCoder::Arithmetic) { }
 
 		PixelFormat::Type pf;	/// pixel format
 		int dwtLevels;			/// num of dwt levels
 		size_t compressRate;	/// number of least significant bits that won't be encoded
 		int quantizationStep;	/// scalar quantization step
 		WaveletType waveletType;/// wavelet to be used
+		unsigned numThreads;	/// number of threads for dwt, tiles and channels, 0 means all hardware threads
+		cv::Size tileSize;		/// size of independently coded tiles, empty means whole image,
+								/// it must be divisible by 2^dwtLevels (2^(dwtLevels + 1) wide for YCbCr422)
+		EntropyCoder entropyCoder;	/// coder of quantized coefs, spiht is faster and doesn't need arithmetic coding
+		SymbolCoder symbolCoder;	/// coder of ezw dominant pass, range coder is faster than bitwise arithmetic coder
 	};
 
 	/** 
 	 * Read file in wlf format to OpenCV matrix.
+	 * File is mapped to memory and decoded straight from page cache.
 	 * @param file path
+	 * @param resolutionReduction number of finest dwt levels that aren't
+	 *     inverted, result is then 2^resolutionReduction times smaller in
+	 *     both dimensions. Must not be greater than number of dwt levels in file.
+	 * @param numThreads number of threads for dwt, tiles and channels, 0 means all hardware threads
 	 * @return OpenCV matrix with 8bits per pixel and BGR color format
 	 * @throws std::runtime_error when reading failed
 	 */
-	static cv::Mat read(const char* file);
+	static cv::Mat read(const char* file, int resolutionReduction = 0, unsigned numThreads = 0);
+
+	/**
+	 * Read wlf image from memory, see read(const char*, int, unsigned).
+	 * Coded data are decoded in place, so buffer isn't copied.
+	 * @param data buffer with whole file, it's owned by caller
+	 * @param size size of buffer in bytes
+	 */
+	static cv::Mat read(const uint8_t* data, size_t size, int resolutionReduction = 0, unsigned numThreads = 0);
+
+	/**
+	 * Read only rectangular region of file in wlf format. Only tiles that
+	 * overlap region are decoded and inverse dwt is computed just for coefs
+	 * that affect region, so result is same as read(file)(region) but faster
+	 * for small regions of big images.
+	 * Entropy decoding isn't bounded by region, every coded pass of each
+	 * overlapping tile is decoded whole. Image saved without tiles is one
+	 * tile, so all its channels are entropy decoded and only inverse dwt
+	 * is saved. Save big images with tiles to read their regions fast.
+	 * @param file path
+	 * @param region part of image to reconstruct
+	 * @param numThreads number of threads for dwt, tiles and channels, 0 means all hardware threads
+	 * @return OpenCV matrix with 8bits per pixel, BGR color format and size of region
+	 * @throws std::runtime_error when reading failed or region isn't inside of image
+	 */
+	static cv::Mat readRegion(const char* file, const cv::Rect& region, unsigned numThreads = 0);
+
+	/**
+	 * Read region of wlf image in memory, see readRegion(const char*, const cv::Rect&, unsigned).
+	 * @param data buffer with whole file, it's owned by caller
+	 * @param size size of buffer in bytes
+	 */
+	static cv::Mat readRegion(const uint8_t* data, size_t size, const cv::Rect& region, unsigned numThreads = 0);
 
 	/**
 	 * Saves OpenCV matrix to file in wlf format.
 	 * @param file path to output file
-	 * @param img OpenCV matrix with 8bits per pixel and BGR color format
+	 * @param img OpenCV matrix with 8bits per pixel and BGR color format, its size
+	 *     must be divisible by 2^dwtLevels (2^(dwtLevels + 1) wide for YCbCr422)
 	 * @param params wlf format parameter
-	 * @throws std::runtime_error when saving failed
+	 * @throws std::runtime_error when saving failed or image size isn't divisible
 	 */
 	static void save(const char* file, const cv::Mat& img, const Params& params = Params());
 };
@@ -0,0 +1,376 @@
+/**
+ * @file main.cpp
+ *
+ * @author Jan Dusek <xdusek17@stud.fit.vutbr.cz>
+ * @date 2013
+ */
+
+#include "wavelettransform.h"
+#include "cdf97wavelet.h"
+#include "cdf53wavelet.h"
+#include "cpufeatures.h"
+#include "spihtencoder.h"
+#include "spihtdecoder.h"
+#include "ezwencoder.h"
+#include "ezwdecoder.h"
+#include "colorplanes.h"
+#include "utils.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+
+struct BenchOptions
+{
+	int size;		/// width and height of benchmarked plane
+	int repeat;		/// number of repetitions, best time is reported
+};
+
+typedef std::function<void (const BenchOptions&)> Benchmark;
+typedef std::map<std::string, Benchmark> BenchmarkMap;
+
+/**
+ * Runs func repeat times and returns best wall time in seconds.
+ * Best time is used because it's least affected by other processes.
+ */
+template <typename Func>
+double measure(int repeat, Func func) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double best = 0.0;
+	for (int i = 0; i < repeat; ++i) {
+		auto start = Clock::now();
+		func();
+		auto end = Clock::now();
+
+		double elapsed = std::chrono::duration<double>(end - start).count();
+		if (i == 0 || elapsed < best)
+			best = elapsed;
+	}
+	return best;
+}
+
+void report(const std::string& name, const std::string& variant, double bytes, double seconds) {
+	std::cout << std::left << std::setw(24) << name << std::setw(10) << variant
+		<< std::right << std::fixed << std::setprecision(1) << std::setw(10)
+		<< bytes / seconds / (1024.0 * 1024.0) << " MB/s" << std::endl;
+}
+
+cv::Mat randomPlane(int size, int type) {
+	cv::Mat plane(size, size, type);
+	cv::randu(plane, cv::Scalar::all(0), cv::Scalar::all(255));
+	return plane;
+}
+
+/**
+ * Benchmarks row transforms and 2d transform of wavelet with every
+ * instruction set that wavelet has kernels for.
+ */
+template <typename WaveletType>
+void benchWavelet(const std::string& name, const BenchOptions& opts) {
+	typedef typename WaveletType::impl_type value_type;
+
+	auto source = randomPlane(opts.size, WaveletTransformTraits<value_type>::cvMatType);
+	double bytes = static_cast<double>(source.total() * source.elemSize());
+
+	static const SimdLevel levels[] = { SimdLevel::None, SimdLevel::Sse2, SimdLevel::Sse41, SimdLevel::Avx2 };
+	for (auto level : levels) {
+		WaveletType wavelet(level);
+		// skip levels that wavelet doesn't have kernels for, or cpu doesn't support
+		if (wavelet.simdLevel() != level)
+			continue;
+
+		cv::Mat plane = source.clone();
+
+		double fwd = measure(opts.repeat, [&] () {
+			for (int y = 0; y < plane.rows; ++y)
+				wavelet.forward(ArrayRef<value_type>(plane.ptr<value_type>(y), plane.cols));
+		});
+		report(name + " rows forward", simdLevelName(level), bytes, fwd);
+
+		double inv = measure(opts.repeat, [&] () {
+			for (int y = 0; y < plane.rows; ++y)
+				wavelet.inverse(ArrayRef<value_type>(plane.ptr<value_type>(y), plane.cols));
+		});
+		report(name + " rows inverse", simdLevelName(level), bytes, inv);
+
+		std::unique_ptr<WaveletTransform> wt(
+			WaveletTransformFactory::create(std::make_shared<WaveletType>(level), 4));
+		double fwd2d = measure(opts.repeat, [&] () {
+			source.copyTo(plane);
+			wt->forward2d(plane);
+		});
+		report(name + " 2d forward", simdLevelName(level), bytes, fwd2d);
+	}
+}
+
+void benchCdf97(const BenchOptions& opts) {
+	benchWavelet<Cdf97Wavelet>("cdf97", opts);
+}
+
+void benchCdf53(const BenchOptions& opts) {
+	benchWavelet<Cdf53Wavelet>("cdf53", opts);
+}
+
+/// Get cdf 5/3 coefs of random plane, they're input of coef coders.
+cv::Mat dwtPlane(int size, int numlevels) {
+	auto plane = randomPlane(size, CV_32S);
+	std::unique_ptr<WaveletTransform> wt(WaveletTransformFactory::create(std::make_shared<Cdf53Wavelet>(), numlevels));
+	wt->forward2d(plane);
+	return plane;
+}
+
+/**
+ * Benchmarks spiht coding of dwt coefs in both layouts.
+ * Throughput is computed from size of coef plane.
+ */
+void benchSpiht(const BenchOptions& opts) {
+	const int numlevels = 4;
+	auto source = dwtPlane(opts.size, numlevels);
+	double bytes = static_cast<double>(source.total() * source.elemSize());
+	int steps = SpihtEncoder::computeMaxSteps(source);
+
+	static const CoefLayout layouts[] = { CoefLayout::RowMajor, CoefLayout::Morton };
+	static const char* layoutNames[] = { "rowmajor", "morton" };
+	for (int i = 0; i < 2; ++i) {
+		std::string encoded;
+		double enc = measure(opts.repeat, [&] () {
+			std::ostringstream ss;
+			{
+				SpihtEncoder encoder(std::make_shared<BitStreamWriter>(&ss));
+				encoder.encode(source, numlevels, steps, 0, layouts[i]);
+			}
+			encoded = ss.str();
+		});
+		report("spiht encode", layoutNames[i], bytes, enc);
+
+		cv::Mat decoded(source.size(), CV_32S);
+		double dec = measure(opts.repeat, [&] () {
+			std::istringstream ss(encoded);
+			decoded.setTo(cv::Scalar::all(0));
+			SpihtDecoder decoder(std::make_shared<BitStreamReader>(&ss));
+			decoder.decode(numlevels, steps, 0, decoded, layouts[i]);
+		});
+		report("spiht decode", layoutNames[i], bytes, dec);
+	}
+}
+
+/**
+ * Benchmarks ezw coding of dwt coefs with both dominant pass coders.
+ * Throughput is computed from size of coef plane.
+ */
+void benchEzw(const BenchOptions& opts) {
+	auto source = dwtPlane(opts.size, 4);
+	double bytes = static_cast<double>(source.total() * source.elemSize());
+	auto threshold = EzwEncoder::computeInitTreshold(source);
+
+	for (int range = 0; range < 2; ++range) {
+		std::string dominant, subord;
+		double enc = measure(opts.repeat, [&] () {
+			std::ostringstream dominantSS, subordSS;
+			{
+				auto subordBS = std::make_shared<BitStreamWriter>(&subordSS);
+				cv::Mat coefs = source.clone();
+				if (range) {
+					EzwEncoder encoder(std::make_shared<RangeEncoder>(&dominantSS), subordBS);
+					encoder.encode(coefs, threshold, 0, CoefLayout::Morton);
+				} else {
+					EzwEncoder encoder(std::make_shared<ArithmeticEncoder>(std::make_shared<BitStreamWriter>(&dominantSS)), subordBS);
+					encoder.encode(coefs, threshold, 0, CoefLayout::Morton);
+				}
+			}
+			dominant = dominantSS.str();
+			subord = subordSS.str();
+		});
+		report("ezw encode", range ? "range" : "arith", bytes, enc);
+
+		// passes are decoded from memory, truncated ones are completed by zeros
+		cv::Mat decoded(source.size(), CV_32S);
+		auto decode = [&] (size_t dominantSize, size_t subordSize) {
+			auto dominantData = reinterpret_cast<const uint8_t*>(dominant.data());
+			auto subordBS = std::make_shared<BitStreamReader>(reinterpret_cast<const uint8_t*>(subord.data()), subordSize,
+				BitStreamReader::EndPolicy::ZeroFill);
+			decoded.setTo(cv::Scalar::all(0));
+			if (range) {
+				EzwDecoder decoder(std::make_shared<RangeDecoder>(dominantData, dominantSize), subordBS);
+				decoder.decode(threshold, 0, decoded, CoefLayout::Morton);
+			} else {
+				EzwDecoder decoder(std::make_shared<ArithmeticDecoder>(std::make_shared<BitStreamReader>(dominantData, dominantSize)), subordBS);
+				decoder.decode(threshold, 0, decoded, CoefLayout::Morton);
+			}
+		};
+
+		double dec = measure(opts.repeat, [&] () {
+			decode(dominant.size(), subord.size());
+		});
+		report("ezw decode", range ? "range" : "arith", bytes, dec);
+
+		double half = measure(opts.repeat, [&] () {
+			decode(dominant.size() / 2, subord.size() / 2);
+		});
+		report("ezw decode half", range ? "range" : "arith", bytes, half);
+		std::cout << "  dominant pass " << dominant.size() << " B" << std::endl;
+	}
+}
+
+/**
+ * Benchmarks range coding with adaptive models of 256 symbol alphabet.
+ * Throughput is computed from number of coded symbols, one byte each.
+ */
+void benchModels(const BenchOptions& opts) {
+	const size_t numSymbols = 256;
+	cv::Mat source(opts.size, opts.size, CV_8U);
+	cv::randn(source, cv::Scalar::all(128), cv::Scalar::all(20));
+	const uint8_t* symbols = source.ptr<uint8_t>();
+	double bytes = static_cast<double>(source.total());
+
+	auto benchModel = [&] (const std::string& name, std::function<unsigned (RangeEncoder*, RangeDecoder*)> code) {
+		std::string encoded;
+		double enc = measure(opts.repeat, [&] () {
+			std::ostringstream ss;
+			{
+				RangeEncoder encoder(&ss);
+				code(&encoder, nullptr);
+			}
+			encoded = ss.str();
+		});
+		report("range encode", name, bytes, enc);
+
+		double dec = measure(opts.repeat, [&] () {
+			std::istringstream ss(encoded);
+			RangeDecoder decoder(&ss);
+			if (code(nullptr, &decoder) != 0)
+				throw std::runtime_error("Range decoder failed!");
+		});
+		report("range decode", name, bytes, dec);
+	};
+
+	// every variant codes all symbols and returns number of wrongly decoded ones
+	benchModel("adaptive", [&] (RangeEncoder* encoder, RangeDecoder* decoder) {
+		AdaptiveDataModel model(numSymbols, RangeCoderTraits::MAX_TOTAL);
+		unsigned errors = 0;
+		for (size_t i = 0; i < source.total(); ++i) {
+			if (encoder)
+				encoder->encode(symbols[i], model);
+			else
+				errors += decoder->decode(model) != symbols[i];
+		}
+		return errors;
+	});
+	benchModel("fenwick", [&] (RangeEncoder* encoder, RangeDecoder* decoder) {
+		FenwickDataModel model(numSymbols, RangeCoderTraits::MAX_TOTAL);
+		unsigned errors = 0;
+		for (size_t i = 0; i < source.total(); ++i) {
+			if (encoder)
+				encoder->encode(symbols[i], model);
+			else
+				errors += decoder->decode(model) != symbols[i];
+		}
+		return errors;
+	});
+}
+
+/**
+ * Benchmarks splitting bgr image to planes and merging them back for
+ * every pixel format, with scalar code and with vector kernels.
+ * Throughput is computed from size of bgr image.
+ */
+void benchColor(const BenchOptions& opts) {
+	typedef WlfImage::PixelFormat::Type PixelType;
+
+	auto source = randomPlane(opts.size, CV_8UC3);
+	double bytes = static_cast<double>(source.total() * source.elemSize());
+
+	static const PixelType formats[] = { PixelType::RGB, PixelType::Gray, PixelType::YCbCr444, PixelType::YCbCr422 };
+	static const char* formatNames[] = { "rgb", "gray", "ycbcr444", "ycbcr422" };
+	static const SimdLevel levels[] = { SimdLevel::None, SimdLevel::Sse2 };
+	for (int i = 0; i < 4; ++i) {
+		for (auto level : levels) {
+			// only ycbcr formats have kernels
+			bool hasKernels = formats[i] == PixelType::YCbCr444 || formats[i] == PixelType::YCbCr422;
+			if (level != SimdLevel::None && (!hasKernels || clampSimdLevel(level) != level))
+				continue;
+
+			std::vector<cv::Mat> planes;
+			double split = measure(opts.repeat, [&] () {
+				splitToPlanes(formats[i], source, CV_32F, planes, level);
+			});
+			report(std::string("color split ") + formatNames[i], simdLevelName(level), bytes, split);
+
+			cv::Mat merged(source.size(), CV_8UC3);
+			double merge = measure(opts.repeat, [&] () {
+				mergeFromPlanes(formats[i], planes, 1.0, 0, merged, level);
+			});
+			report(std::string("color merge ") + formatNames[i], simdLevelName(level), bytes, merge);
+		}
+	}
+}
+
+void printUsage(const BenchmarkMap& benchmarks) {
+	std::cout << "wlfbench [-s SIZE -n REPEAT] [BENCHMARK...]\n"
+		<< "  -s SIZE       width and height of benchmarked data default(2048)\n"
+		<< "  -n REPEAT     number of repetitions, best is reported default(5)\n"
+		<< "  BENCHMARK     benchmarks to run, all by default, one of [";
+	for (auto iter = benchmarks.begin(); iter != benchmarks.end(); ++iter)
+		std::cout << (iter == benchmarks.begin() ? "" : ", ") << iter->first;
+	std::cout << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+	BenchmarkMap benchmarks = create_map<std::string, Benchmark>
+		("cdf97", benchCdf97)("cdf53", benchCdf53)("spiht", benchSpiht)("ezw", benchEzw)("models", benchModels)
+		("color", benchColor);
+
+	BenchOptions opts;
+	opts.size = 2048;
+	opts.repeat = 5;
+
+	std::vector<std::string> selected;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if ((arg == "-s" || arg == "-n") && i + 1 < argc) {
+			int value = atoi(argv[++i]);
+			if (value <= 0) {
+				printUsage(benchmarks);
+				return 2;
+			}
+			(arg == "-s" ? opts.size : opts.repeat) = value;
+		} else if (benchmarks.count(arg)) {
+			selected.push_back(arg);
+		} else {
+			std::cerr << "Error: Unknown argument \"" << arg << "\"" << std::endl;
+			printUsage(benchmarks);
+			return 2;
+		}
+	}
+
+	if (selected.empty()) {
+		for (auto& bench : benchmarks)
+			selected.push_back(bench.first);
+	}
+
+	// 2d transforms need size divisible by 2^levels
+	opts.size = (opts.size + 15) & ~15;
+
+	std::cout << "cpu simd level: " << simdLevelName(detectSimdLevel())
+		<< ", size: " << opts.size << "x" << opts.size << std::endl;
+
+	try {
+		for (auto& name : selected)
+			benchmarks[name](opts);
+	} catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
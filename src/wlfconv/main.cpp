@@ -20,13 +20,23 @@
 typedef std::map<std::string, std::string> OptionsMap;
 typedef std::map<std::string, WlfImage::PixelFormat::Type> PixelFormatMap;
 typedef std::map<std::string, WlfImage::WaveletType> WaveletTypeMap;
+typedef std::map<std::string, WlfImage::EntropyCoder> EntropyCoderMap;
+typedef std::map<std::string, WlfImage::SymbolCoder> SymbolCoderMap;
 
 const PixelFormatMap pfMap = create_map<std::string, WlfImage::PixelFormat::Type>
 	("rgb", WlfImage::PixelFormat::Type::RGB)("ycbcr444", WlfImage::PixelFormat::Type::YCbCr444)
 	("ycbcr422", WlfImage::PixelFormat::Type::YCbCr422);
 
 const WaveletTypeMap wtMap = create_map<std::string, WlfImage::WaveletType>
-	("9/7", WlfImage::WaveletType::Cdf97)("5/3", WlfImage::WaveletType::Cdf53);
+	("9/7", WlfImage::WaveletType::Cdf97)("5/3", WlfImage::WaveletType::Cdf53)("haar", WlfImage::WaveletType::Haar)
+	("9/7m", WlfImage::WaveletType::Int97)("13/7", WlfImage::WaveletType::Int137)
+	("9/7fix", WlfImage::WaveletType::Fix97);
+
+const EntropyCoderMap ecMap = create_map<std::string, WlfImage::EntropyCoder>
+	("ezw", WlfImage::EntropyCoder::Ezw)("spiht", WlfImage::EntropyCoder::Spiht);
+
+const SymbolCoderMap scMap = create_map<std::string, WlfImage::SymbolCoder>
+	("arith", WlfImage::SymbolCoder::Arithmetic)("range", WlfImage::SymbolCoder::Range);
 
 template <typename T>
 T extractFromString(const std::string& str) {
@@ -36,8 +46,8 @@ T extractFromString(const std::string& str) {
 	return result;
 }
 
-void decompress(const std::string& in, const std::string& out) {
-	auto img = WlfImage::read(in.c_str());
+void decompress(const std::string& in, const std::string& out, const OptionsMap& options) {
+	auto img = WlfImage::read(in.c_str(), extractFromString<int>(options.at("r")), extractFromString<unsigned>(options.at("t")));
 	cv::imwrite(out, img);
 }
 
@@ -52,18 +62,28 @@ void compress(const std::string& in, const std::string& out, const OptionsMap& o
 	params.quantizationStep = extractFromString<decltype(params.quantizationStep)>(options.at("q"));
 	params.waveletType = wtMap.at(options.at("w"));
 	params.pf = pfMap.at(options.at("f"));
+	params.entropyCoder = ecMap.at(options.at("e"));
+	params.symbolCoder = scMap.at(options.at("a"));
+	params.numThreads = extractFromString<decltype(params.numThreads)>(options.at("t"));
+	int tileSize = extractFromString<int>(options.at("s"));
+	params.tileSize = cv::Size(tileSize, tileSize);
 	WlfImage::save(out.c_str(), img, params);
 }
 
 void printUsage() {
-	std::cout << "wlfconv [-f FORMAT -w WLET -l DWTLEVELS -c RATE -q STEP] INPUT OUTPUT\n"
-		<< "wlfconv -d INPUT OUTPUT\n"
+	std::cout << "wlfconv [-f FORMAT -w WLET -e CODER -a SYMCODER -l DWTLEVELS -c RATE -q STEP -t THREADS -s TILE] INPUT OUTPUT\n"
+		<< "wlfconv -d [-r LEVELS -t THREADS] INPUT OUTPUT\n"
 		<< "  -f FORMAT     pixel format one of [rgb, ycbcr444(default), ycbcr422]\n"
-		<< "  -w WLET       wavelet type, one of [9/7(default), 5/3]\n"
+		<< "  -w WLET       wavelet type, one of [9/7(default), 5/3, haar, 9/7m, 13/7, 9/7fix]\n"
+		<< "  -e CODER      entropy coder, one of [ezw(default), spiht]\n"
+		<< "  -a SYMCODER   coder of ezw symbols, one of [arith(default), range]\n"
 		<< "  -l DWTLEVELS  resolution of discrete wavelet transfom default(4)\n"
 		<< "  -c RATE       number of bitplanes that will be discarted default(0)\n"
 		<< "  -q STEP       scalar quantization step default(1)\n"
+		<< "  -t THREADS    number of threads used by dwt, tiles and channels default(0 = all cores)\n"
+		<< "  -s TILE       size of square tiles coded independently default(0 = no tiles)\n"
 		<< "  -d            this option means decompression instead compression\n"
+		<< "  -r LEVELS     decompress image 2^LEVELS times smaller default(0)\n"
 		<< "  INPUT         input file in standard raster format (that opencv can handle)\n"
 		<< "  OUTPUT        output file in wlf format\n";
 }
@@ -110,7 +130,7 @@ std::vector<std::string> parseCmdline(int argc, char* argv[], OptionsMap& option
 int main(int argc, char* argv[]) {
 	std::string input, output;
 	OptionsMap options = create_map<OptionsMap::key_type, OptionsMap::mapped_type>
-		("d", "false")("f", "ycbcr444")("w", "9/7")("c", "0")("q", "1")("l", "4");
+		("d", "false")("f", "ycbcr444")("w", "9/7")("e", "ezw")("a", "arith")("c", "0")("q", "1")("l", "4")("t", "0")("r", "0")("s", "0");
 	try {
 		auto lefovers = parseCmdline(argc, argv, options);
 		if (lefovers.size() != 2)
@@ -125,7 +145,7 @@ int main(int argc, char* argv[]) {
 
 	try {
 		if (options["d"] == "true") {
-			decompress(input, output);
+			decompress(input, output, options);
 		} else {
 			compress(input, output, options);
 		}
@@ -12,19 +12,22 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <cstdlib>
 
 void printUsage() {
-	std::cout << "wlfshow IMAGE\n";
+	std::cout << "wlfshow IMAGE [REDUCTION]\n"
+		<< "  REDUCTION     show image 2^REDUCTION times smaller default(0)\n";
 }
 
 int main(int argc, char* argv[]) {
-	if (argc != 2) {
+	if (argc != 2 && argc != 3) {
 		printUsage();
 		return 1;
 	}
 
 	try {
-		auto img = WlfImage::read(argv[1]);
+		int reduction = argc == 3 ? atoi(argv[2]) : 0;
+		auto img = WlfImage::read(argv[1], reduction);
 		cv::imshow(std::string("wlfshow - ") + argv[1], img);
 		cv::waitKey(0);
 	} catch (std::exception& e) {
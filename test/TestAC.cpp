@@ -2,9 +2,12 @@
 
 #include "arithmdecoder.h"
 #include "arithmencoder.h"
+#include "rangedecoder.h"
+#include "rangeencoder.h"
 
 #include <sstream>
 #include <vector>
+#include <cstdlib>
 
 class TestAC : public ::testing::Test
 {
@@ -37,4 +40,134 @@ TEST_F(TestAC, DynamicDataModel) {
 		auto decoded = ad.decode(&dataModel);
 		EXPECT_EQ(simpleData[i], decoded);
 	}
-}
\ No newline at end of file
+}
+
+TEST_F(TestAC, CloseOnce) {
+	std::vector<uint8_t> once, twice;
+	AdaptiveDataModel onceModel(4), twiceModel(4);
+	{
+		ArithmeticEncoder ae(std::make_shared<BitStreamWriter>(&once));
+		for (auto val : simpleData)
+			ae.encode(val, onceModel);
+		ae.close();
+	}
+	{
+		// destructor closes too, code mustn't be finished twice
+		ArithmeticEncoder ae(std::make_shared<BitStreamWriter>(&twice));
+		for (auto val : simpleData)
+			ae.encode(val, twiceModel);
+		ae.close();
+		ae.close();
+	}
+	EXPECT_EQ(once, twice);
+}
+
+TEST_F(TestAC, TemplatedMatchesPolymorphic) {
+	std::ostringstream templated, polymorphic;
+
+	AdaptiveDataModel adaptive(4);
+	StaticDataModel fixed(std::vector<unsigned>(4, 3));
+	{
+		ArithmeticEncoder ae(std::make_shared<BitStreamWriter>(&templated));
+		for (auto val : simpleData) {
+			ae.encode(val, adaptive);
+			ae.encode(val, fixed);
+		}
+	}
+	adaptive.reset();
+	{
+		ArithmeticEncoder ae(std::make_shared<BitStreamWriter>(&polymorphic));
+		for (auto val : simpleData) {
+			ae.encode(val, static_cast<DataModel*>(&adaptive));
+			ae.encode(val, static_cast<DataModel*>(&fixed));
+		}
+	}
+	adaptive.reset();
+
+	auto encoded = templated.str();
+	EXPECT_EQ(encoded, polymorphic.str());
+
+	std::istringstream is(encoded);
+	ArithmeticDecoder ad(std::make_shared<BitStreamReader>(&is));
+	for (auto val : simpleData) {
+		EXPECT_EQ(val, ad.decode(adaptive));
+		EXPECT_EQ(val, ad.decode(fixed));
+	}
+}
+
+TEST_F(TestAC, RangeCoder) {
+	// skewed random symbols, long enough to cross output blocks and rescale model
+	std::vector<unsigned> symbols;
+	srand(3);
+	for (int i = 0; i < 500000; ++i)
+		symbols.push_back(rand() % 8 == 0 ? rand() % 4 : 3);
+
+	std::ostringstream os;
+	AdaptiveDataModel dataModel(4, RangeCoderTraits::MAX_TOTAL);
+	{
+		RangeEncoder re(&os);
+		for (auto val : simpleData)
+			re.encode(val, dataModel);
+		for (auto val : symbols)
+			re.encode(val, dataModel);
+	}
+	dataModel.reset();
+
+	// about 0.7 bits per symbol is entropy of this source
+	auto encoded = os.str();
+	EXPECT_GT(symbols.size() * 0.75 / 8, encoded.size());
+
+	std::istringstream is(encoded);
+	RangeDecoder rd(&is);
+	for (auto val : simpleData)
+		EXPECT_EQ(static_cast<unsigned>(val), rd.decode(dataModel));
+	size_t errors = 0;
+	for (auto val : symbols)
+		errors += rd.decode(dataModel) != val;
+	EXPECT_EQ(0u, errors);
+}
+
+TEST_F(TestAC, FenwickDataModel) {
+	// big alphabet with geometric like distribution, long enough to rescale models
+	const size_t numSymbols = 300;
+	std::vector<unsigned> symbols;
+	srand(5);
+	for (int i = 0; i < 200000; ++i)
+		symbols.push_back(static_cast<unsigned>(rand() % (1 + rand() % numSymbols)));
+
+	// fenwick model evolves same way as adaptive one, so codes are same
+	std::ostringstream adaptiveArith, fenwickArith, adaptiveRange, fenwickRange;
+	{
+		AdaptiveDataModel adaptive(numSymbols);
+		FenwickDataModel fenwick(numSymbols);
+		ArithmeticEncoder adaptiveAe(std::make_shared<BitStreamWriter>(&adaptiveArith));
+		ArithmeticEncoder fenwickAe(std::make_shared<BitStreamWriter>(&fenwickArith));
+		for (auto val : symbols) {
+			adaptiveAe.encode(val, adaptive);
+			fenwickAe.encode(val, fenwick);
+		}
+	}
+	{
+		AdaptiveDataModel adaptive(numSymbols, RangeCoderTraits::MAX_TOTAL);
+		FenwickDataModel fenwick(numSymbols, RangeCoderTraits::MAX_TOTAL);
+		RangeEncoder adaptiveRe(&adaptiveRange);
+		RangeEncoder fenwickRe(&fenwickRange);
+		for (auto val : symbols) {
+			adaptiveRe.encode(val, adaptive);
+			fenwickRe.encode(val, fenwick);
+		}
+	}
+	EXPECT_EQ(adaptiveArith.str(), fenwickArith.str());
+	EXPECT_EQ(adaptiveRange.str(), fenwickRange.str());
+
+	std::istringstream arithIs(fenwickArith.str()), rangeIs(fenwickRange.str());
+	ArithmeticDecoder ad(std::make_shared<BitStreamReader>(&arithIs));
+	RangeDecoder rd(&rangeIs);
+	FenwickDataModel arithModel(numSymbols), rangeModel(numSymbols, RangeCoderTraits::MAX_TOTAL);
+	size_t errors = 0;
+	for (auto val : symbols) {
+		errors += ad.decode(arithModel) != val;
+		errors += rd.decode(rangeModel) != val;
+	}
+	EXPECT_EQ(0u, errors);
+}
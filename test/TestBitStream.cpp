@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <bitstream.h>
+
+#include <sstream>
+#include <cstdlib>
+
+class TestBitStream : public ::testing::Test
+{
+protected:
+	void SetUp() {
+		// random fields of all widths, they cross words at every offset
+		srand(3);
+		for (int i = 0; i < 5000; ++i) {
+			unsigned n = rand() % 33;
+			uint32_t value = static_cast<uint32_t>(rand()) ^ (static_cast<uint32_t>(rand()) << 16);
+			widths.push_back(n);
+			values.push_back(n < 32 ? value & ((1U << n) - 1) : value);
+		}
+	}
+
+	void write(BitStreamWriter& writer) {
+		for (size_t i = 0; i < values.size(); ++i) {
+			if (widths[i] == 1)
+				writer.writeBit(values[i] != 0);
+			else
+				writer.writeBits(values[i], widths[i]);
+		}
+		writer.flush();
+	}
+
+	void expectRead(BitStreamReader& reader) {
+		for (size_t i = 0; i < values.size(); ++i) {
+			if (widths[i] == 1)
+				EXPECT_EQ(values[i] != 0, reader.readBit());
+			else
+				EXPECT_EQ(values[i], reader.readBits(widths[i]));
+		}
+	}
+
+	std::vector<unsigned> widths;
+	std::vector<uint32_t> values;
+};
+
+TEST_F(TestBitStream, SingleBits) {
+	// bits are stored from most significant bit of byte
+	std::vector<uint8_t> buffer;
+	{
+		BitStreamWriter writer(&buffer);
+		for (int bit : { 1, 0, 1, 1, 0, 0, 0, 1, 1, 1 })
+			writer.writeBit(bit != 0);
+	}
+	ASSERT_EQ(2u, buffer.size());
+	EXPECT_EQ(0xb1, buffer[0]);
+	EXPECT_EQ(0xc0, buffer[1]);
+
+	BitStreamReader reader(buffer);
+	EXPECT_EQ(0x2c7u, reader.readBits(10));
+	EXPECT_EQ(0u, reader.readBits(6));
+	EXPECT_THROW(reader.readBit(), std::runtime_error);
+}
+
+TEST_F(TestBitStream, AllSinksMatch) {
+	std::vector<uint8_t> vec;
+	BitStreamWriter vecWriter(&vec);
+	write(vecWriter);
+	EXPECT_EQ(vec.size(), vecWriter.size());
+
+	std::ostringstream os;
+	BitStreamWriter streamWriter(&os);
+	write(streamWriter);
+	EXPECT_EQ(std::string(vec.begin(), vec.end()), os.str());
+
+	std::vector<uint8_t> span(vec.size());
+	BitStreamWriter spanWriter(span.data(), span.size());
+	write(spanWriter);
+	EXPECT_EQ(vec, span);
+	EXPECT_EQ(span.size(), spanWriter.size());
+
+	// fixed buffer can't grow
+	uint8_t small[4];
+	BitStreamWriter smallWriter(small, sizeof(small));
+	smallWriter.writeBits(0xffff, 16);
+	EXPECT_THROW(write(smallWriter), std::runtime_error);
+}
+
+TEST_F(TestBitStream, AllSourcesMatch) {
+	std::vector<uint8_t> buffer;
+	{
+		BitStreamWriter writer(&buffer);
+		write(writer);
+	}
+
+	BitStreamReader vecReader(buffer);
+	expectRead(vecReader);
+
+	BitStreamReader spanReader(buffer.data(), buffer.size());
+	expectRead(spanReader);
+
+	std::istringstream is(std::string(buffer.begin(), buffer.end()));
+	BitStreamReader streamReader(&is);
+	expectRead(streamReader);
+}
+
+TEST_F(TestBitStream, FlushAlignsToByte) {
+	std::vector<uint8_t> buffer(1, 0x55);
+	{
+		// writer appends to existing vector
+		BitStreamWriter writer(&buffer);
+		writer.writeBits(5, 3);
+		writer.flush();
+		writer.writeBits(1, 2);
+	}
+	ASSERT_EQ(3u, buffer.size());
+	EXPECT_EQ(0x55, buffer[0]);
+	EXPECT_EQ(0xa0, buffer[1]);
+	EXPECT_EQ(0x40, buffer[2]);
+}
+
+TEST_F(TestBitStream, ZeroFill) {
+	std::vector<uint8_t> buffer(2, 0xff);
+	BitStreamReader reader(buffer, BitStreamReader::EndPolicy::ZeroFill);
+	EXPECT_EQ(0x1ffu, reader.readBits(9));
+	EXPECT_EQ(9u, reader.consumedBits());
+	EXPECT_FALSE(reader.pastEnd());
+
+	// zeros follow end of data, they aren't counted as consumed
+	EXPECT_EQ(0xfe000u, reader.readBits(20));
+	EXPECT_EQ(16u, reader.consumedBits());
+	EXPECT_TRUE(reader.pastEnd());
+	for (int i = 0; i < 1000; ++i)
+		EXPECT_FALSE(reader.readBit());
+	EXPECT_EQ(16u, reader.consumedBits());
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <colorplanes.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <vector>
+
+static double maxDifference(const cv::Mat& test, const cv::Mat& ref) {
+	double maxVal = 0;
+	cv::Mat diff;
+	cv::absdiff(test, ref, diff);
+	cv::minMaxLoc(diff.reshape(1), nullptr, &maxVal);
+	return maxVal;
+}
+
+TEST(TestColorPlanes, SplitMatchesSeparatePasses) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	// color transform, split, subsampling and type conversion done one after another
+	cv::Mat transformed;
+	cv::cvtColor(image, transformed, CV_BGR2YCrCb);
+	std::vector<cv::Mat> expected;
+	cv::split(transformed, expected);
+	for (size_t i = 1; i < expected.size(); ++i) {
+		cv::Mat full = expected[i].clone();
+		cv::resize(full, expected[i], cv::Size(), 0.5, 1.0, cv::INTER_NEAREST);
+	}
+
+	std::vector<cv::Mat> planes;
+	splitToPlanes(WlfImage::PixelFormat::Type::YCbCr422, image, CV_32F, planes);
+	ASSERT_EQ(expected.size(), planes.size());
+	for (size_t i = 0; i < planes.size(); ++i) {
+		ASSERT_EQ(expected[i].size(), planes[i].size());
+		cv::Mat converted;
+		expected[i].convertTo(converted, CV_32F);
+		EXPECT_GE(1.0, maxDifference(planes[i], converted));
+	}
+
+	EXPECT_THROW(splitToPlanes(WlfImage::PixelFormat::Type::RGB, planes[0], CV_32F, planes), std::runtime_error);
+}
+
+TEST(TestColorPlanes, RgbRoundTrip) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	std::vector<cv::Mat> planes;
+	splitToPlanes(WlfImage::PixelFormat::Type::RGB, image, CV_32S, planes);
+	cv::Mat merged(image.size(), CV_8UC3);
+	mergeFromPlanes(WlfImage::PixelFormat::Type::RGB, planes, 1.0, 0, merged);
+	EXPECT_EQ(0.0, maxDifference(merged, image));
+
+	// scaled planes are rounded back to same pixels
+	for (auto& plane : planes)
+		plane.convertTo(plane, plane.type(), 4.0);
+	mergeFromPlanes(WlfImage::PixelFormat::Type::RGB, planes, 0.25, 0, merged);
+	EXPECT_EQ(0.0, maxDifference(merged, image));
+}
+
+TEST(TestColorPlanes, MergeMatchesSeparatePasses) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	std::vector<cv::Mat> planes;
+	splitToPlanes(WlfImage::PixelFormat::Type::YCbCr422, image, CV_32F, planes);
+
+	// upsampling and color transform done one after another
+	std::vector<cv::Mat> channels(planes.size());
+	for (size_t i = 0; i < planes.size(); ++i) {
+		cv::Mat converted;
+		planes[i].convertTo(converted, CV_8U);
+		if (i > 0)
+			cv::resize(converted, channels[i], cv::Size(), 2.0, 1.0, cv::INTER_NEAREST);
+		else
+			channels[i] = converted;
+	}
+	cv::Mat merged, expected;
+	cv::merge(channels, merged);
+	cv::cvtColor(merged, expected, CV_YCrCb2BGR);
+
+	cv::Mat result(image.size(), CV_8UC3);
+	mergeFromPlanes(WlfImage::PixelFormat::Type::YCbCr422, planes, 1.0, 0, result);
+	EXPECT_GE(1.0, maxDifference(result, expected));
+
+	// part starting at odd column takes chroma of column before it
+	cv::Rect part(5, 10, 100, 50);
+	std::vector<cv::Mat> partPlanes = { planes[0](part), planes[1](cv::Rect(2, 10, 51, 50)), planes[2](cv::Rect(2, 10, 51, 50)) };
+	cv::Mat partResult(part.size(), CV_8UC3);
+	mergeFromPlanes(WlfImage::PixelFormat::Type::YCbCr422, partPlanes, 1.0, 1, partResult);
+	EXPECT_EQ(0.0, maxDifference(partResult, result(part)));
+}
+
+TEST(TestColorPlanes, SimdMatchesScalar) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	static const WlfImage::PixelFormat::Type formats[] = {
+		WlfImage::PixelFormat::Type::YCbCr444, WlfImage::PixelFormat::Type::YCbCr422
+	};
+	// odd widths leave tails of rows to scalar code
+	for (int cols : { 101, 102, 103, 104 }) {
+		cv::Mat part = image(cv::Rect(3, 7, cols, 20));
+		for (auto pf : formats) {
+			for (int type : { CV_32F, CV_32S }) {
+				std::vector<cv::Mat> scalar, simd;
+				splitToPlanes(pf, part, type, scalar, SimdLevel::None);
+				splitToPlanes(pf, part, type, simd);
+				for (size_t i = 0; i < scalar.size(); ++i)
+					EXPECT_EQ(0.0, maxDifference(simd[i], scalar[i]));
+
+				// values out of 8bit range must saturate same way
+				for (auto& plane : scalar)
+					plane.convertTo(plane, type, 1.7, -60.0);
+				for (int offset = 0; offset < 2; ++offset) {
+					cv::Mat scalarResult(part.size(), CV_8UC3), simdResult(part.size(), CV_8UC3);
+					mergeFromPlanes(pf, scalar, 0.6, offset, scalarResult, SimdLevel::None);
+					mergeFromPlanes(pf, scalar, 0.6, offset, simdResult);
+					EXPECT_EQ(0.0, maxDifference(simdResult, scalarResult));
+				}
+			}
+		}
+	}
+}
@@ -3,6 +3,12 @@
 #include <wavelettransform.h>
 #include <cdf97wavelet.h>
 #include <cdf53wavelet.h>
+#include <haarwavelet.h>
+#include <int97wavelet.h>
+#include <int137wavelet.h>
+#include <fix97wavelet.h>
+#include <threadpool.h>
+#include <linewavelettransform.h>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -80,4 +86,396 @@ TEST_F(TestDwt, OneDimCdf53) {
 	for (size_t i = 0; i < origData.size(); i++) {
 		EXPECT_EQ(origData[i], data[i]);
 	}
-}
\ No newline at end of file
+}
+
+TEST_F(TestDwt, OneDimCdf97SimdMatchesScalar) {
+	// sizes chosen to hit both vector bodies and scalar tails of kernels
+	static const size_t sizes[] = { 2, 6, 16, 18, 34, 64, 1030 };
+	for (auto size : sizes) {
+		std::vector<float> data(size);
+		std::generate(data.begin(), data.end(), [] () { return static_cast<float>(rand() % 255); });
+
+		auto scalarData = data;
+		auto simdData = data;
+
+		Cdf97Wavelet scalarWavelet(SimdLevel::None);
+		Cdf97Wavelet simdWavelet;
+
+		scalarWavelet.forward(scalarData);
+		simdWavelet.forward(simdData);
+		for (size_t i = 0; i < size; i++) {
+			EXPECT_NEAR(scalarData[i], simdData[i], 1e-3) << "forward size " << size << " index " << i;
+		}
+
+		scalarWavelet.inverse(scalarData);
+		simdWavelet.inverse(simdData);
+		for (size_t i = 0; i < size; i++) {
+			EXPECT_NEAR(scalarData[i], simdData[i], 1e-3) << "inverse size " << size << " index " << i;
+			EXPECT_NEAR(data[i], simdData[i], 1e-3);
+		}
+	}
+}
+
+TEST_F(TestDwt, OneDimCdf53SimdMatchesScalar) {
+	// sizes chosen to hit both vector bodies and scalar tails of kernels
+	static const size_t sizes[] = { 2, 4, 10, 16, 18, 34, 64, 1030 };
+	for (auto size : sizes) {
+		std::vector<int32_t> data(size);
+		std::generate(data.begin(), data.end(), [] () { return rand() % 4096 - 2048; });
+
+		auto scalarData = data;
+		auto simdData = data;
+
+		Cdf53Wavelet scalarWavelet(SimdLevel::None);
+		Cdf53Wavelet simdWavelet;
+
+		scalarWavelet.forward(scalarData);
+		simdWavelet.forward(simdData);
+		for (size_t i = 0; i < size; i++) {
+			EXPECT_EQ(scalarData[i], simdData[i]) << "forward size " << size << " index " << i;
+		}
+
+		simdWavelet.inverse(simdData);
+		for (size_t i = 0; i < size; i++) {
+			EXPECT_EQ(data[i], simdData[i]) << "inverse size " << size << " index " << i;
+		}
+	}
+}
+
+TEST_F(TestDwt, TwoDimCdf53SimdMatchesScalar) {
+	std::unique_ptr<WaveletTransform> scalarWt(WaveletTransformFactory::create(std::make_shared<Cdf53Wavelet>(SimdLevel::None), 3));
+	std::unique_ptr<WaveletTransform> simdWt(WaveletTransformFactory::create(std::make_shared<Cdf53Wavelet>(), 3));
+
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat scalarImg;
+	image.convertTo(scalarImg, CV_32SC3);
+	scalarImg = scalarImg.reshape(1);
+	cv::Mat simdImg = scalarImg.clone();
+
+	scalarWt->forward2d(scalarImg);
+	simdWt->forward2d(simdImg);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(simdImg, scalarImg));
+
+	scalarWt->inverse2d(scalarImg);
+	simdWt->inverse2d(simdImg);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(simdImg, scalarImg));
+}
+
+/**
+ * Computes one level of 2d dwt the straightforward way, every row and then
+ * every column is copied out and transformed by 1d wavelet.
+ */
+template <typename T>
+static void separableForward(Wavelet<T>& wavelet, cv::Mat& m) {
+	for (int y = 0; y < m.rows; ++y)
+		wavelet.forward(ArrayRef<T>(m.ptr<T>(y), m.cols));
+
+	std::vector<T> column(m.rows);
+	for (int x = 0; x < m.cols; ++x) {
+		for (int y = 0; y < m.rows; ++y)
+			column[y] = m.at<T>(y, x);
+		wavelet.forward(column);
+		for (int y = 0; y < m.rows; ++y)
+			m.at<T>(y, x) = column[y];
+	}
+}
+
+/// Inverse of separableForward, columns and then rows are inverted.
+template <typename T>
+static void separableInverse(Wavelet<T>& wavelet, cv::Mat& m) {
+	std::vector<T> column(m.rows);
+	for (int x = 0; x < m.cols; ++x) {
+		for (int y = 0; y < m.rows; ++y)
+			column[y] = m.at<T>(y, x);
+		wavelet.inverse(column);
+		for (int y = 0; y < m.rows; ++y)
+			m.at<T>(y, x) = column[y];
+	}
+
+	for (int y = 0; y < m.rows; ++y)
+		wavelet.inverse(ArrayRef<T>(m.ptr<T>(y), m.cols));
+}
+
+TEST_F(TestDwt, TwoDimColumnStripsMatchSeparable) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	// width not divisible by column strip width
+	cv::Mat gray = image.reshape(1)(cv::Rect(0, 0, 200, 100));
+
+	Cdf97Wavelet cdf97;
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create<Cdf97Wavelet>(1));
+	cv::Mat floatImg, floatRef;
+	gray.convertTo(floatImg, CV_32F);
+	floatRef = floatImg.clone();
+	cdf97Wt->forward2d(floatImg);
+	separableForward(cdf97, floatRef);
+	EXPECT_NEAR(0.0, computeDifference(floatImg, floatRef), 1e-5);
+
+	// inverse starts from same coefs, so only inverse strips are compared
+	floatRef = floatImg.clone();
+	cdf97Wt->inverse2d(floatImg);
+	separableInverse(cdf97, floatRef);
+	EXPECT_NEAR(0.0, computeDifference(floatImg, floatRef), 1e-5);
+	cv::Mat floatOrig;
+	gray.convertTo(floatOrig, CV_32F);
+	EXPECT_NEAR(0.0, computeDifference(floatImg, floatOrig), 1e-3);
+
+	Cdf53Wavelet cdf53;
+	std::unique_ptr<WaveletTransform> cdf53Wt(WaveletTransformFactory::create<Cdf53Wavelet>(1));
+	cv::Mat intImg, intRef;
+	gray.convertTo(intImg, CV_32S);
+	intRef = intImg.clone();
+	cdf53Wt->forward2d(intImg);
+	separableForward(cdf53, intRef);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intImg, intRef));
+
+	intRef = intImg.clone();
+	cdf53Wt->inverse2d(intImg);
+	separableInverse(cdf53, intRef);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intImg, intRef));
+	cv::Mat intOrig;
+	gray.convertTo(intOrig, CV_32S);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intImg, intOrig));
+}
+
+TEST_F(TestDwt, TwoDimThreadedMatchesSingleThread) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray = image.reshape(1);
+	auto pool = std::make_shared<ThreadPool>(4);
+
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create<Cdf97Wavelet>(3));
+	cv::Mat floatImg, floatRef;
+	gray.convertTo(floatRef, CV_32F);
+	floatImg = floatRef.clone();
+	cdf97Wt->forward2d(floatRef);
+	cdf97Wt->setThreadPool(pool);
+	cdf97Wt->forward2d(floatImg);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(floatImg, floatRef));
+	cdf97Wt->inverse2d(floatImg);
+	cdf97Wt->setThreadPool(nullptr);
+	cdf97Wt->inverse2d(floatRef);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(floatImg, floatRef));
+
+	std::unique_ptr<WaveletTransform> cdf53Wt(WaveletTransformFactory::create<Cdf53Wavelet>(3));
+	cv::Mat intImg, intRef;
+	gray.convertTo(intRef, CV_32S);
+	intImg = intRef.clone();
+	cdf53Wt->forward2d(intRef);
+	cdf53Wt->setThreadPool(pool);
+	cdf53Wt->forward2d(intImg);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intImg, intRef));
+	cdf53Wt->inverse2d(intImg);
+	cdf53Wt->setThreadPool(nullptr);
+	cdf53Wt->inverse2d(intRef);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intImg, intRef));
+}
+
+template <typename T>
+static cv::Mat lineForward(LineWaveletTransform<T>& lwt, const cv::Mat& image) {
+	cv::Mat dwt(image.size(), image.type());
+	lwt.beginForward([&dwt] (size_t y, size_t x, const T* coefs, size_t count) {
+		std::copy(coefs, coefs + count, dwt.ptr<T>(static_cast<int>(y)) + x);
+	});
+	for (int y = 0; y < image.rows; ++y)
+		lwt.pushRow(image.ptr<T>(y));
+	return dwt;
+}
+
+template <typename T>
+static cv::Mat lineInverse(LineWaveletTransform<T>& lwt, const cv::Mat& dwt) {
+	cv::Mat image(dwt.size(), dwt.type());
+	lwt.inverse([&dwt] (size_t y, size_t x, T* coefs, size_t count) {
+		const T* src = dwt.ptr<T>(static_cast<int>(y)) + x;
+		std::copy(src, src + count, coefs);
+	}, [&image] (size_t y, const T* row) {
+		std::copy(row, row + image.cols, image.ptr<T>(static_cast<int>(y)));
+	});
+	return image;
+}
+
+TEST_F(TestDwt, LineBasedMatchesTwoDim) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray = image.reshape(1);
+	const int levels = 3;
+
+	auto cdf97 = std::make_shared<Cdf97Wavelet>();
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create(cdf97, levels));
+	LineWaveletTransform<float> cdf97Lwt(cdf97, levels, gray.cols, gray.rows);
+	cv::Mat floatImg, floatRef;
+	gray.convertTo(floatImg, CV_32F);
+	floatRef = floatImg.clone();
+	cdf97Wt->forward2d(floatRef);
+	cv::Mat floatDwt = lineForward(cdf97Lwt, floatImg);
+	EXPECT_NEAR(0.0, computeDifference(floatDwt, floatRef), 1e-5);
+	EXPECT_NEAR(0.0, computeDifference(lineInverse(cdf97Lwt, floatDwt), floatImg), 1e-3);
+
+	auto cdf53 = std::make_shared<Cdf53Wavelet>();
+	std::unique_ptr<WaveletTransform> cdf53Wt(WaveletTransformFactory::create(cdf53, levels));
+	LineWaveletTransform<int32_t> cdf53Lwt(cdf53, levels, gray.cols, gray.rows);
+	cv::Mat intImg, intRef;
+	gray.convertTo(intImg, CV_32S);
+	intRef = intImg.clone();
+	cdf53Wt->forward2d(intRef);
+	cv::Mat intDwt = lineForward(cdf53Lwt, intImg);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(intDwt, intRef));
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(lineInverse(cdf53Lwt, intDwt), intImg));
+
+	// only few rows per level are buffered
+	EXPECT_LT(cdf97Lwt.bufferedValues(), gray.total() / 8);
+}
+
+template <typename WaveletType>
+static void checkIntegerReconstruction(const cv::Mat& gray) {
+	// small sizes exercise symmetric extension of 4 tap steps
+	static const size_t sizes[] = { 2, 4, 6, 8, 34 };
+	for (auto size : sizes) {
+		std::vector<int32_t> data(size);
+		std::generate(data.begin(), data.end(), [] () { return rand() % 4096 - 2048; });
+		auto origData = data;
+
+		WaveletType wavelet;
+		wavelet.forward(data);
+		wavelet.inverse(data);
+		for (size_t i = 0; i < size; i++) {
+			EXPECT_EQ(origData[i], data[i]) << "size " << size << " index " << i;
+		}
+	}
+
+	cv::Mat image, orig;
+	gray.convertTo(image, CV_32S);
+	orig = image.clone();
+	std::unique_ptr<WaveletTransform> wt(WaveletTransformFactory::create<WaveletType>(4));
+	wt->forward2d(image);
+	wt->inverse2d(image);
+	cv::Mat diff;
+	cv::absdiff(image, orig, diff);
+	EXPECT_EQ(0, cv::countNonZero(diff));
+}
+
+TEST_F(TestDwt, TwoDimIntegerLiftingSchemes) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray = image.reshape(1);
+	checkIntegerReconstruction<HaarWavelet>(gray);
+	checkIntegerReconstruction<Int97Wavelet>(gray);
+	checkIntegerReconstruction<Int137Wavelet>(gray);
+
+	// haar approx coef is floor of average, detail coef is difference
+	std::vector<int32_t> data(2);
+	data[0] = 7;
+	data[1] = 2;
+	HaarWavelet haar;
+	haar.forward(data);
+	EXPECT_EQ(4, data[0]);
+	EXPECT_EQ(-5, data[1]);
+}
+
+TEST_F(TestDwt, LineBasedMatchesTwoDimFourTap) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray = image.reshape(1);
+	const int levels = 3;
+
+	auto int137 = std::make_shared<Int137Wavelet>();
+	std::unique_ptr<WaveletTransform> wt(WaveletTransformFactory::create(int137, levels));
+	LineWaveletTransform<int32_t> lwt(int137, levels, gray.cols, gray.rows);
+	cv::Mat img, ref;
+	gray.convertTo(img, CV_32S);
+	ref = img.clone();
+	wt->forward2d(ref);
+	cv::Mat dwt = lineForward(lwt, img);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(dwt, ref));
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(lineInverse(lwt, dwt), img));
+}
+
+TEST_F(TestDwt, TwoDimReducedResolutionInverse) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray;
+	image.reshape(1).convertTo(gray, CV_32S);
+
+	std::unique_ptr<WaveletTransform> wt(WaveletTransformFactory::create<Cdf53Wavelet>(3));
+	cv::Mat dwt = gray.clone();
+	wt->forward2d(dwt);
+	wt->inverse2d(dwt, 2);
+
+	// partially inverted dwt has approx band of 2 level dwt in its corner
+	std::unique_ptr<WaveletTransform> wt2(WaveletTransformFactory::create<Cdf53Wavelet>(2));
+	cv::Mat ref = gray.clone();
+	wt2->forward2d(ref);
+	cv::Rect approx(0, 0, gray.cols / 4, gray.rows / 4);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(dwt(approx), ref(approx)));
+
+	EXPECT_DOUBLE_EQ(1.0, wt->lowpassGain());
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create<Cdf97Wavelet>(3));
+	EXPECT_NEAR(2.0, cdf97Wt->lowpassGain(), 1e-5);
+}
+
+TEST_F(TestDwt, TwoDimRegionInverse) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray;
+	image.reshape(1).convertTo(gray, CV_32S);
+	cv::Mat grayF;
+	gray.convertTo(grayF, CV_32F);
+
+	std::unique_ptr<WaveletTransform> cdf53Wt(WaveletTransformFactory::create<Cdf53Wavelet>(3));
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create<Cdf97Wavelet>(3));
+	cv::Mat dwt53 = gray.clone(), dwt97 = grayF.clone();
+	cdf53Wt->forward2d(dwt53);
+	cdf97Wt->forward2d(dwt97);
+
+	// regions inside, touching borders and whole image
+	cv::Rect regions[] = {
+		cv::Rect(100, 60, 150, 90), cv::Rect(0, 0, 33, 17), cv::Rect(gray.cols - 7, gray.rows - 5, 7, 5),
+		cv::Rect(201, 0, 1, gray.rows), cv::Rect(0, 0, gray.cols, gray.rows)
+	};
+	for (auto& region : regions) {
+		cv::Mat region53 = cdf53Wt->inverse2dRegion(dwt53, region);
+		ASSERT_EQ(region.size(), region53.size());
+		EXPECT_DOUBLE_EQ(0.0, computeDifference(region53, gray(region)));
+
+		cv::Mat region97 = cdf97Wt->inverse2dRegion(dwt97, region);
+		ASSERT_EQ(region.size(), region97.size());
+		EXPECT_NEAR(0.0, computeDifference(region97, grayF(region)), 1e-3);
+	}
+
+	EXPECT_THROW(cdf53Wt->inverse2dRegion(dwt53, cv::Rect(gray.cols - 10, 0, 11, 10)), std::runtime_error);
+}
+
+TEST_F(TestDwt, TwoDimFix97) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	cv::Mat gray, grayF;
+	image.reshape(1).convertTo(gray, CV_32S);
+	gray.convertTo(grayF, CV_32F);
+
+	std::unique_ptr<WaveletTransform> fix97Wt(WaveletTransformFactory::create<Fix97Wavelet>(4));
+	std::unique_ptr<WaveletTransform> cdf97Wt(WaveletTransformFactory::create<Cdf97Wavelet>(4));
+	EXPECT_EQ(CV_32S, fix97Wt->getType());
+
+	cv::Mat dwt = gray.clone(), dwtF = grayF.clone();
+	fix97Wt->forward2d(dwt);
+	cdf97Wt->forward2d(dwtF);
+
+	// fixed point coefs differ from float ones only by rounding
+	cv::Mat dwtConverted;
+	dwt.convertTo(dwtConverted, CV_32F);
+	EXPECT_NEAR(0.0, computeDifference(dwtConverted, dwtF), 1.0);
+
+	fix97Wt->inverse2d(dwt);
+	EXPECT_NEAR(0.0, computeDifference(dwt, gray), 1.0);
+	EXPECT_NEAR(2.0, fix97Wt->lowpassGain(), 1e-2);
+}
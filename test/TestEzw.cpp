@@ -4,6 +4,7 @@
 #include <ezwencoder.h>
 
 #include <sstream>
+#include <cstdlib>
 
 class TestEzw : public ::testing::Test
 {
@@ -38,7 +39,49 @@ protected:
 		}
 	}
 
+	/**
+	 * Encodes data and decodes it to decoded, which may be part of bigger
+	 * matrix. Encoding clears data. Passes are kept in dominant and subord.
+	 */
+	void roundTrip(cv::Mat data, cv::Mat decoded, CoefLayout layout = CoefLayout::RowMajor, bool rangeCoder = false) {
+		std::ostringstream ods, oss;
+		auto threshold = EzwEncoder::computeInitTreshold(data);
+		{
+			auto subordBS = std::make_shared<BitStreamWriter>(&oss);
+			if (rangeCoder)
+				EzwEncoder(std::make_shared<RangeEncoder>(&ods), subordBS).encode(data, threshold, 0, layout);
+			else
+				EzwEncoder(std::make_shared<ArithmeticEncoder>(std::make_shared<BitStreamWriter>(&ods)), subordBS).encode(data, threshold, 0, layout);
+		}
+		dominant = ods.str();
+		subord = oss.str();
+
+		std::istringstream ids(dominant);
+		std::istringstream iss(subord);
+		auto subordBS = std::make_shared<BitStreamReader>(&iss);
+		decoded.setTo(0);
+		if (rangeCoder)
+			EzwDecoder(std::make_shared<RangeDecoder>(&ids), subordBS).decode(threshold, 0, decoded, layout);
+		else
+			EzwDecoder(std::make_shared<ArithmeticDecoder>(std::make_shared<BitStreamReader>(&ids)), subordBS).decode(threshold, 0, decoded, layout);
+	}
+
+	/// Encodes copy of data and decodes it back.
+	cv::Mat roundTrip(const cv::Mat& data, CoefLayout layout = CoefLayout::RowMajor, bool rangeCoder = false) {
+		cv::Mat decoded(data.rows, data.cols, CV_32S);
+		roundTrip(data.clone(), decoded, layout, rangeCoder);
+		return decoded;
+	}
+
+	static int countDifferences(const cv::Mat& test, const cv::Mat& ref) {
+		cv::Mat diff;
+		cv::absdiff(test, ref, diff);
+		return cv::countNonZero(diff);
+	}
+
 	cv::Mat simpleData;
+	std::string dominant;	/// dominant pass of last roundTrip
+	std::string subord;		/// subordinate pass of last roundTrip
 };
 
 TEST_F(TestEzw, Simple) {
@@ -61,4 +104,96 @@ TEST_F(TestEzw, Simple) {
 			EXPECT_EQ(expected.at<int32_t>(i, j), decoded.at<int32_t>(i, j));
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST_F(TestEzw, SparseRandom) {
+	// few big coefs among small ones exercise zerotrees of all depths
+	cv::Mat data = cv::Mat::zeros(64, 32, CV_32S);
+	srand(17);
+	for (int i = 0; i < 200; ++i)
+		data.at<int32_t>(rand() % data.rows, rand() % data.cols) = rand() % 31 - 15;
+	for (int i = 0; i < 10; ++i)
+		data.at<int32_t>(rand() % data.rows, rand() % data.cols) = rand() % 4001 - 2000;
+
+	EXPECT_EQ(0, countDifferences(roundTrip(data), data));
+}
+
+TEST_F(TestEzw, NonContinuousMatrix) {
+	// coded matrices may be roi of bigger ones
+	cv::Mat big = cv::Mat::zeros(12, 10, CV_32S);
+	cv::Mat data(big, cv::Rect(1, 2, 4, 8));
+	simpleData.copyTo(data);
+	ASSERT_FALSE(data.isContinuous());
+
+	cv::Mat expected = data.clone();
+	cv::Mat decodedBig = cv::Mat::zeros(12, 10, CV_32S);
+	cv::Mat decoded(decodedBig, cv::Rect(1, 2, 4, 8));
+	roundTrip(data, decoded);
+	EXPECT_EQ(0, countDifferences(decoded, expected));
+}
+
+TEST_F(TestEzw, MortonLayout) {
+	MortonLayout layout(6, 4);
+	EXPECT_EQ(0u, layout.index(0, 0));
+	EXPECT_EQ(1u, layout.index(1, 0));
+	EXPECT_EQ(2u, layout.index(0, 1));
+	EXPECT_EQ(12u, layout.index(2, 2));
+	for (size_t y = 0; y < layout.rows; ++y) {
+		for (size_t x = 0; x < layout.cols; ++x) {
+			EXPECT_EQ(x, layout.x(layout.index(x, y)));
+			EXPECT_EQ(y, layout.y(layout.index(x, y)));
+		}
+	}
+
+	// holes of long and narrow matrix would take more memory than coefs
+	EXPECT_EQ(CoefLayout::Morton, preferredLayout(512, 256));
+	EXPECT_EQ(CoefLayout::RowMajor, preferredLayout(1024, 64));
+	EXPECT_EQ(CoefLayout::RowMajor, preferredLayout(MortonLayout::MAX_SIZE, 2));
+	EXPECT_THROW(MortonLayout(MortonLayout::MAX_SIZE, 2), std::runtime_error);
+	MortonLayout biggest(MortonLayout::MAX_SIZE - 1, MortonLayout::MAX_SIZE - 1);
+	EXPECT_EQ(static_cast<size_t>(0xfffffffd), biggest.size());
+
+	// layout changes only memory order, streams must be same
+	roundTrip(simpleData, CoefLayout::RowMajor);
+	std::string rowDominant = dominant, rowSubord = subord;
+	EXPECT_EQ(0, countDifferences(roundTrip(simpleData, CoefLayout::Morton), simpleData));
+	EXPECT_EQ(rowDominant, dominant);
+	EXPECT_EQ(rowSubord, subord);
+}
+
+TEST_F(TestEzw, RangeCoder) {
+	EXPECT_EQ(0, countDifferences(roundTrip(simpleData, CoefLayout::Morton, true), simpleData));
+	EXPECT_EQ(0, countDifferences(roundTrip(simpleData, CoefLayout::RowMajor, true), simpleData));
+}
+
+TEST_F(TestEzw, TruncatedStreams) {
+	cv::Mat data(64, 32, CV_32S);
+	srand(5);
+	for (int y = 0; y < data.rows; ++y) {
+		for (int x = 0; x < data.cols; ++x)
+			data.at<int32_t>(y, x) = (rand() % 201 - 100) / (1 + x + y);
+	}
+	data.at<int32_t>(0, 0) = 1000;
+
+	cv::Mat expected = data.clone();
+	std::vector<uint8_t> dominant, subord;
+	auto threshold = EzwEncoder::computeInitTreshold(data);
+	{
+		auto ae = std::make_shared<ArithmeticEncoder>(std::make_shared<BitStreamWriter>(&dominant));
+		EzwEncoder ezwEncoder(ae, std::make_shared<BitStreamWriter>(&subord));
+		ezwEncoder.encode(data, threshold);
+	}
+
+	// missing end of passes is read as zeros, coefs are only less precise
+	auto zeroFill = BitStreamReader::EndPolicy::ZeroFill;
+	auto dominantBS = std::make_shared<BitStreamReader>(dominant.data(), dominant.size() / 2, zeroFill);
+	auto subordBS = std::make_shared<BitStreamReader>(subord.data(), subord.size() / 2, zeroFill);
+	EzwDecoder ezwDecoder(std::make_shared<ArithmeticDecoder>(dominantBS), subordBS);
+	cv::Mat decoded = cv::Mat::zeros(data.rows, data.cols, CV_32S);
+	ASSERT_NO_THROW(ezwDecoder.decode(threshold, 0, decoded));
+	EXPECT_TRUE(dominantBS->pastEnd());
+	EXPECT_EQ(dominant.size() / 2 * 8, dominantBS->consumedBits());
+
+	// biggest coef is coded first, it's decoded at least to precision of initial threshold
+	EXPECT_EQ(expected.at<int32_t>(0, 0) & ~(threshold - 1), decoded.at<int32_t>(0, 0) & ~(threshold - 1));
+}
@@ -5,6 +5,14 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstring>
+
 double computeDifference(const cv::Mat& test, const cv::Mat& ref) {
 	cv::Mat diff;
 	cv::absdiff(test, ref, diff);
@@ -23,4 +31,381 @@ TEST(TestImage, Simple) {
 	cv::imwrite("lena-inv.png", read);
 
 	EXPECT_NEAR(0.0, computeDifference(read, image), 1.0);
-}
\ No newline at end of file
+}
+
+TEST(TestImage, ReducedResolution) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.dwtLevels = 3;
+	WlfImage::save("lena-reduced.wlf", image, params);
+
+	for (int reduction = 1; reduction <= params.dwtLevels; ++reduction) {
+		cv::Mat read = WlfImage::read("lena-reduced.wlf", reduction);
+		EXPECT_EQ(image.cols >> reduction, read.cols);
+		EXPECT_EQ(image.rows >> reduction, read.rows);
+
+		// approx band keeps brightness of original image
+		cv::Scalar readMean = cv::mean(read), imageMean = cv::mean(image);
+		for (int c = 0; c < 3; ++c)
+			EXPECT_NEAR(imageMean.val[c], readMean.val[c], 2.0);
+	}
+
+	EXPECT_THROW(WlfImage::read("lena-reduced.wlf", params.dwtLevels + 1), std::runtime_error);
+}
+
+TEST(TestImage, Region) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.dwtLevels = 3;
+	params.pf = WlfImage::PixelFormat::Type::YCbCr422;
+	WlfImage::save("lena-region.wlf", image, params);
+
+	cv::Mat full = WlfImage::read("lena-region.wlf");
+	cv::Rect regions[] = { cv::Rect(101, 60, 150, 90), cv::Rect(0, 0, image.cols, image.rows) };
+	for (auto& region : regions) {
+		cv::Mat read = WlfImage::readRegion("lena-region.wlf", region);
+		ASSERT_EQ(region.size(), read.size());
+		EXPECT_NEAR(0.0, computeDifference(read, full(region)), 0.01);
+	}
+
+	EXPECT_THROW(WlfImage::readRegion("lena-region.wlf", cv::Rect(-1, 0, 10, 10)), std::runtime_error);
+}
+
+TEST(TestImage, Tiled) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.dwtLevels = 3;
+	params.pf = WlfImage::PixelFormat::Type::YCbCr422;
+	WlfImage::save("lena-whole.wlf", image, params);
+	params.tileSize = cv::Size(128, 96);
+	WlfImage::save("lena-tiled.wlf", image, params);
+
+	// tiles change only coefs near tile borders
+	cv::Mat whole = WlfImage::read("lena-whole.wlf");
+	cv::Mat tiled = WlfImage::read("lena-tiled.wlf");
+	ASSERT_EQ(image.size(), tiled.size());
+	EXPECT_NEAR(0.0, computeDifference(tiled, whole), 1.0);
+
+	// single threaded decode is same
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("lena-tiled.wlf", 0, 1), tiled));
+
+	// tile can be decoded alone
+	cv::Rect tile(128, 96, 128, 96);
+	EXPECT_NEAR(0.0, computeDifference(WlfImage::readRegion("lena-tiled.wlf", tile), tiled(tile)), 0.01);
+	cv::Rect crossing(100, 80, 100, 50);
+	EXPECT_NEAR(0.0, computeDifference(WlfImage::readRegion("lena-tiled.wlf", crossing), tiled(crossing)), 0.01);
+
+	cv::Mat reduced = WlfImage::read("lena-tiled.wlf", 2);
+	EXPECT_EQ(image.cols / 4, reduced.cols);
+	EXPECT_EQ(image.rows / 4, reduced.rows);
+
+	params.tileSize = cv::Size(100, 96);
+	EXPECT_THROW(WlfImage::save("lena-tiled.wlf", image, params), std::runtime_error);
+
+	// image without tiles must be divisible too
+	params.tileSize = cv::Size();
+	EXPECT_THROW(WlfImage::save("lena-tiled.wlf", image(cv::Rect(0, 0, 500, 512)), params), std::runtime_error);
+}
+
+template <typename T>
+static T readField(std::istream& in) {
+	T value;
+	in.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+template <typename T>
+static void writeField(std::ostream& out, const T& value) {
+	out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Rewrites untiled EZW file with arithmetic coder to version 1 format.
+ * Version 1 header has image fields right after magic and lacks version,
+ * tile size, coders and tile offsets. Channels are coded same way as in
+ * current version, so they are copied.
+ */
+static void writeVersion1(const char* current, const char* file) {
+	std::ifstream in(current, std::ios_base::binary);
+	std::ofstream out(file, std::ios_base::binary);
+	char magic[8];
+	in.read(magic, sizeof(magic));
+	out.write(magic, sizeof(magic));
+
+	// zero width and version
+	readField<uint32_t>(in);
+	readField<uint8_t>(in);
+
+	writeField(out, readField<uint32_t>(in));	// width
+	writeField(out, readField<uint32_t>(in));	// height
+	writeField(out, readField<uint8_t>(in));	// pixel format
+	writeField(out, readField<uint8_t>(in));	// dwt levels
+	writeField(out, readField<uint8_t>(in));	// wavelet
+	writeField(out, readField<uint16_t>(in));	// quantization step
+
+	// tile size, entropy coder, symbol coder and offsets of single tile
+	readField<uint32_t>(in);
+	readField<uint32_t>(in);
+	readField<uint8_t>(in);
+	readField<uint8_t>(in);
+	readField<uint64_t>(in);
+	readField<uint64_t>(in);
+
+	out << in.rdbuf();
+}
+
+TEST(TestImage, ReadVersion1) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::save("lena-current.wlf", image);
+	writeVersion1("lena-current.wlf", "lena-v1.wlf");
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("lena-v1.wlf"), WlfImage::read("lena-current.wlf")));
+}
+
+TEST(TestImage, ReadVersion2) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.tileSize = cv::Size(256, 128);
+	params.symbolCoder = WlfImage::SymbolCoder::Range;
+	WlfImage::save("lena-v2.wlf", image, params);
+
+	// zero width after magic is followed by version
+	std::ifstream in("lena-v2.wlf", std::ios_base::binary);
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	ASSERT_LT(12u, data.size());
+	EXPECT_EQ(std::string(4, '\0'), data.substr(8, 4));
+	EXPECT_EQ(2, data[12]);
+	EXPECT_NEAR(0.0, computeDifference(WlfImage::read("lena-v2.wlf"), image), 2.0);
+
+	// newer versions are rejected
+	data[12] = 3;
+	EXPECT_THROW(WlfImage::read(reinterpret_cast<const uint8_t*>(data.data()), data.size()), std::runtime_error);
+}
+
+TEST(TestImage, FixedPoint97) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.waveletType = WlfImage::WaveletType::Fix97;
+	params.quantizationStep = 4;
+	WlfImage::save("lena-fix97.wlf", image, params);
+	cv::Mat fixed = WlfImage::read("lena-fix97.wlf");
+
+	params.waveletType = WlfImage::WaveletType::Cdf97;
+	WlfImage::save("lena-cdf97.wlf", image, params);
+	cv::Mat floating = WlfImage::read("lena-cdf97.wlf");
+
+	// integer pipeline loses about as much as float one
+	EXPECT_NEAR(computeDifference(floating, image), computeDifference(fixed, image), 0.5);
+}
+
+TEST(TestImage, Spiht) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.waveletType = WlfImage::WaveletType::Cdf53;
+	params.entropyCoder = WlfImage::EntropyCoder::Spiht;
+	params.tileSize = cv::Size(128, 128);
+	WlfImage::save("lena-spiht.wlf", image, params);
+	cv::Mat spiht = WlfImage::read("lena-spiht.wlf");
+
+	// both coders are lossless, so they decode same image
+	params.entropyCoder = WlfImage::EntropyCoder::Ezw;
+	WlfImage::save("lena-ezw.wlf", image, params);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(spiht, WlfImage::read("lena-ezw.wlf")));
+
+	// dropped bitplanes lose less than in ezw, which doesn't round coefs to middle of interval
+	params.compressRate = 3;
+	WlfImage::save("lena-ezw.wlf", image, params);
+	params.entropyCoder = WlfImage::EntropyCoder::Spiht;
+	WlfImage::save("lena-spiht.wlf", image, params);
+	EXPECT_GE(computeDifference(WlfImage::read("lena-ezw.wlf"), image),
+		computeDifference(WlfImage::read("lena-spiht.wlf"), image));
+
+	// bitplanes of first channel, it follows header and offsets of single tile
+	params.tileSize = cv::Size();
+	WlfImage::save("lena-spiht.wlf", image, params);
+	std::ifstream in("lena-spiht.wlf", std::ios_base::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	const size_t bitplanesPos = 36 + 2 * sizeof(uint64_t);
+	int32_t bitplanes[2];
+	ASSERT_LT(bitplanesPos + sizeof(bitplanes), data.size());
+	memcpy(bitplanes, &data[bitplanesPos], sizeof(bitplanes));
+	EXPECT_LE(3, bitplanes[0]);
+	EXPECT_EQ(3, bitplanes[1]);
+
+	// invalid bitplanes in file are rejected
+	const int32_t invalid[][2] = { { bitplanes[0], -1 }, { 31, 3 }, { 2, 3 } };
+	for (const auto& corrupted : invalid) {
+		std::vector<uint8_t> copy = data;
+		memcpy(&copy[bitplanesPos], corrupted, sizeof(bitplanes));
+		EXPECT_THROW(WlfImage::read(copy.data(), copy.size()), std::runtime_error);
+	}
+
+	// channel without any bitplane is still valid
+	params.compressRate = 0;
+	cv::Mat black = cv::Mat::zeros(64, 64, CV_8UC3);
+	WlfImage::save("black-spiht.wlf", black, params);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("black-spiht.wlf"), black));
+
+	// threshold of bitplane 31 doesn't fit to int
+	params.compressRate = 30;
+	WlfImage::save("black-spiht.wlf", black, params);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("black-spiht.wlf"), black));
+	params.compressRate = 31;
+	EXPECT_THROW(WlfImage::save("black-spiht.wlf", black, params), std::runtime_error);
+}
+
+TEST(TestImage, RangeCoder) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.waveletType = WlfImage::WaveletType::Cdf53;
+	WlfImage::save("lena-arith.wlf", image, params);
+	params.symbolCoder = WlfImage::SymbolCoder::Range;
+	WlfImage::save("lena-range.wlf", image, params);
+
+	// symbol coder doesn't change decoded coefs
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("lena-range.wlf"), WlfImage::read("lena-arith.wlf")));
+
+	// and it shouldn't make file noticeably bigger
+	std::ifstream arith("lena-arith.wlf", std::ios_base::binary | std::ios_base::ate);
+	std::ifstream range("lena-range.wlf", std::ios_base::binary | std::ios_base::ate);
+	EXPECT_GT(arith.tellg() * 1.01, range.tellg() * 1.0);
+}
+
+TEST(TestImage, ReadMemory) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.waveletType = WlfImage::WaveletType::Cdf53;
+	params.tileSize = cv::Size(128, 128);
+	WlfImage::save("lena-memory.wlf", image, params);
+
+	std::ifstream in("lena-memory.wlf", std::ios_base::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read(data.data(), data.size()), WlfImage::read("lena-memory.wlf")));
+
+	cv::Rect region(100, 60, 200, 150);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::readRegion(data.data(), data.size(), region),
+		WlfImage::read("lena-memory.wlf")(region)));
+
+	// truncated buffer mustn't be read past its end
+	EXPECT_THROW(WlfImage::read(data.data(), data.size() / 2), std::runtime_error);
+	EXPECT_THROW(WlfImage::read(data.data(), 4), std::runtime_error);
+
+	// version 1 file has no tile offsets, so end of its last channel is missed by channel reader
+	params.tileSize = cv::Size();
+	WlfImage::save("lena-memory.wlf", image, params);
+	writeVersion1("lena-memory.wlf", "lena-v1.wlf");
+	std::ifstream v1("lena-v1.wlf", std::ios_base::binary);
+	data.assign(std::istreambuf_iterator<char>(v1), std::istreambuf_iterator<char>());
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read(data.data(), data.size()), WlfImage::read("lena-memory.wlf")));
+	EXPECT_THROW(WlfImage::read(data.data(), data.size() - 1), std::runtime_error);
+}
+
+TEST(TestImage, ParallelChannels) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	// channels coded in parallel are written in same order as by single thread
+	WlfImage::Params params;
+	params.numThreads = 1;
+	WlfImage::save("lena-serial.wlf", image, params);
+	params.numThreads = 3;
+	WlfImage::save("lena-parallel.wlf", image, params);
+
+	std::ifstream serial("lena-serial.wlf", std::ios_base::binary);
+	std::ifstream parallel("lena-parallel.wlf", std::ios_base::binary);
+	EXPECT_TRUE(std::equal(std::istreambuf_iterator<char>(serial), std::istreambuf_iterator<char>(),
+		std::istreambuf_iterator<char>(parallel)));
+
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("lena-serial.wlf", 0, 3), WlfImage::read("lena-serial.wlf", 0, 1)));
+	cv::Rect region(100, 60, 200, 150);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::readRegion("lena-serial.wlf", region, 3),
+		WlfImage::readRegion("lena-serial.wlf", region, 1)));
+}
+
+TEST(TestImage, PipelinedDecode) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.dwtLevels = 3;
+	params.pf = WlfImage::PixelFormat::Type::YCbCr422;
+	params.tileSize = cv::Size(128, 96);
+	WlfImage::save("lena-pipelined.wlf", image, params);
+
+	// channels reconstructed in any order give same image as serial decode
+	for (int reduction = 0; reduction <= 2; ++reduction) {
+		EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::read("lena-pipelined.wlf", reduction, 3),
+			WlfImage::read("lena-pipelined.wlf", reduction, 1)));
+	}
+	cv::Rect region(100, 80, 250, 120);
+	EXPECT_DOUBLE_EQ(0.0, computeDifference(WlfImage::readRegion("lena-pipelined.wlf", region, 3),
+		WlfImage::readRegion("lena-pipelined.wlf", region, 1)));
+
+	// first channel of last tile starts with its highest spiht bitplane, tiles follow header and offsets
+	params.entropyCoder = WlfImage::EntropyCoder::Spiht;
+	WlfImage::save("lena-pipelined.wlf", image, params);
+	std::ifstream in("lena-pipelined.wlf", std::ios_base::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	const size_t headerLen = 36;
+	size_t numTiles = ((image.cols + 127) / 128) * ((image.rows + 95) / 96);
+	size_t tilesStart = headerLen + (numTiles + 1) * sizeof(uint64_t);
+	uint64_t lastTile;
+	memcpy(&lastTile, &data[headerLen + (numTiles - 1) * sizeof(uint64_t)], sizeof(lastTile));
+	size_t stepsPos = tilesStart + static_cast<size_t>(lastTile);
+	int32_t steps;
+	ASSERT_LT(stepsPos + sizeof(steps), data.size());
+	memcpy(&steps, &data[stepsPos], sizeof(steps));
+	ASSERT_GE(30, steps);
+	ASSERT_LE(0, steps);
+
+	// error in decoding stage, while earlier tiles are reconstructed, stops pipeline and is rethrown
+	steps = 40;
+	memcpy(&data[stepsPos], &steps, sizeof(steps));
+	EXPECT_THROW(WlfImage::read(data.data(), data.size(), 0, 3), std::runtime_error);
+	EXPECT_THROW(WlfImage::readRegion(data.data(), data.size(), cv::Rect(0, 0, image.cols, image.rows), 3), std::runtime_error);
+	EXPECT_NO_THROW(WlfImage::readRegion(data.data(), data.size(), region, 3));
+}
+
+TEST(TestImage, ConcurrentImages) {
+	cv::Mat image = cv::imread("lena.png", CV_LOAD_IMAGE_COLOR);
+	ASSERT_FALSE(!image.data);
+
+	WlfImage::Params params;
+	params.numThreads = 1;
+	WlfImage::save("lena-serial.wlf", image, params);
+	cv::Mat expected = WlfImage::read("lena-serial.wlf", 0, 1);
+
+	// images saved and read from several threads at once share same pool
+	params.numThreads = 3;
+	std::vector<cv::Mat> results(3);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < results.size(); ++i) {
+		threads.emplace_back([&, i] () {
+			std::string file = "lena-concurrent" + std::to_string(i) + ".wlf";
+			WlfImage::save(file.c_str(), image, params);
+			results[i] = WlfImage::read(file.c_str(), 0, 3);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	for (const auto& result : results)
+		EXPECT_DOUBLE_EQ(0.0, computeDifference(result, expected));
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <spihtdecoder.h>
+#include <spihtencoder.h>
+
+#include <sstream>
+#include <cstdlib>
+
+class TestSpiht : public ::testing::Test
+{
+protected:
+	void SetUp() {
+		static const int example[8][8] = { 
+			{ 63,-34, 49, 10,  7, 13,-12,  7 }, 
+			{-31, 23, 14,-13,  3,  4,  6, -1 }, 
+			{ 15, 14,  3,-12,  5, -7,  3,  9 }, 
+			{ -9, -7,-14,  8,  4, -2,  3,  2 }, 
+			{ -5,  9, -1, 47,  4,  6, -2,  2 }, 
+			{  3,  0, -3,  2,  3, -2,  0,  4 }, 
+			{  2, -3,  6, -4,  3,  6,  3,  6 }, 
+			{  5, 11,  5,  6,  0,  3, -4,  4 } 
+		};
+
+		simpleData = cv::Mat(8, 8, CV_32S);
+		for (int i = 0; i < simpleData.rows; ++i) {
+			for (int j = 0; j < simpleData.cols; ++j) {
+				simpleData.at<int32_t>(i, j) = example[i][j];
+			}
+		}
+	}
+
+	/// Encodes data and decodes it back.
+	cv::Mat roundTrip(cv::Mat data, int numlevels, int minStep = 0, CoefLayout layout = CoefLayout::RowMajor) {
+		std::ostringstream os;
+		auto steps = SpihtEncoder::computeMaxSteps(data);
+		{
+			SpihtEncoder spihtEncoder(std::make_shared<BitStreamWriter>(&os));
+			spihtEncoder.encode(data, numlevels, steps, minStep, layout);
+		}
+		encoded = os.str();
+
+		std::istringstream is(encoded);
+		SpihtDecoder spihtDecoder(std::make_shared<BitStreamReader>(&is));
+		cv::Mat decoded = cv::Mat::zeros(data.rows, data.cols, CV_32S);
+		spihtDecoder.decode(numlevels, steps, minStep, decoded, layout);
+		return decoded;
+	}
+
+	cv::Mat simpleData;
+	std::string encoded;	/// stream of last roundTrip
+};
+
+TEST_F(TestSpiht, Simple) {
+	EXPECT_EQ(5, SpihtEncoder::computeMaxSteps(simpleData));
+
+	cv::Mat decoded = roundTrip(simpleData, 3);
+	for (int i = 0; i < simpleData.rows; ++i) {
+		for (int j = 0; j < simpleData.cols; ++j) {
+			EXPECT_EQ(simpleData.at<int32_t>(i, j), decoded.at<int32_t>(i, j));
+		}
+	}
+}
+
+TEST_F(TestSpiht, SparseRandom) {
+	// few big coefs among small ones exercise sets of all depths
+	cv::Mat data = cv::Mat::zeros(64, 32, CV_32S);
+	srand(17);
+	for (int i = 0; i < 200; ++i)
+		data.at<int32_t>(rand() % data.rows, rand() % data.cols) = rand() % 31 - 15;
+	for (int i = 0; i < 10; ++i)
+		data.at<int32_t>(rand() % data.rows, rand() % data.cols) = rand() % 4001 - 2000;
+
+	// too many levels for this size are reduced same way by both sides
+	for (int numlevels = 0; numlevels <= 6; ++numlevels) {
+		cv::Mat diff;
+		cv::absdiff(data, roundTrip(data, numlevels), diff);
+		EXPECT_EQ(0, cv::countNonZero(diff));
+	}
+}
+
+TEST_F(TestSpiht, Lossy) {
+	// coefs are reconstructed within half of lowest coded bitplane
+	cv::Mat decoded = roundTrip(simpleData, 2, 3);
+	cv::Mat diff;
+	cv::absdiff(simpleData, decoded, diff);
+	double maxDiff;
+	cv::minMaxIdx(diff, nullptr, &maxDiff);
+	EXPECT_GE(8.0, maxDiff);
+
+	size_t lossy = encoded.size();
+	roundTrip(simpleData, 2);
+	EXPECT_GT(encoded.size(), lossy);
+}
+
+TEST_F(TestSpiht, MortonLayout) {
+	cv::Mat decoded = roundTrip(simpleData, 3, 0, CoefLayout::Morton);
+	std::string morton = encoded;
+	roundTrip(simpleData, 3);
+
+	// layout changes only memory order, stream must be same
+	EXPECT_EQ(encoded, morton);
+	cv::Mat diff;
+	cv::absdiff(simpleData, decoded, diff);
+	EXPECT_EQ(0, cv::countNonZero(diff));
+}
+
+TEST_F(TestSpiht, Zero) {
+	cv::Mat data = cv::Mat::zeros(16, 16, CV_32S);
+	EXPECT_EQ(-1, SpihtEncoder::computeMaxSteps(data));
+	EXPECT_EQ(0, cv::countNonZero(roundTrip(data, 2)));
+	EXPECT_TRUE(encoded.empty());
+}